@@ -606,6 +606,8 @@ namespace regexp_parser{
 
 
 namespace automaton{
+    constexpr std::size_t lexer::no_class;
+
     node::node(const node &other) : edge(other.edge), token_name(new std::string(*other.token_name)), action(new std::string(*other.action)){}
     node::node(node &&other) : edge(std::move(other.edge)), token_name(std::move(other.token_name)), action(std::move(other.action)){}
 
@@ -620,21 +622,16 @@ namespace automaton{
     }
 
     std::set<std::size_t> closure(const node_pool &pool, std::set<std::size_t> T){
-        std::set<std::size_t> U;
-        do{
-            U = T;
-            std::set<std::size_t> V;
-            for(auto &s : U){
-                std::set<std::size_t> W = edge(pool, s, '\0');
-                V.insert(W.begin(), W.end());
-            }
-            for(auto &i : U){
-                T.insert(i);
-            }
-            for(auto &i : V){
-                T.insert(i);
+        std::vector<std::size_t> stack(T.begin(), T.end());
+        while(!stack.empty()){
+            std::size_t s = stack.back();
+            stack.pop_back();
+            for(auto &i : pool[s].edge){
+                if(i.first == '\0' && T.insert(i.second).second){
+                    stack.push_back(i.second);
+                }
             }
-        }while(T != U);
+        }
         return T;
     }
 
@@ -659,58 +656,95 @@ namespace automaton{
         return s;
     }
 
+    struct subset_hash{
+        std::size_t operator ()(const std::vector<std::size_t> &v) const{
+            std::size_t h = v.size();
+            for(std::size_t n : v){
+                h = h * 1000003 ^ n;
+            }
+            return h;
+        }
+    };
+
     node_pool NFA_to_DFA(const node_pool &pool){
-        node_pool trans;
+        // epsilon closure of every NFA node, sorted.
+        std::vector<std::vector<std::size_t>> eps_closure(pool.size());
         {
-            std::set<char> sigma = collect_char(pool);
-            std::vector<std::set<std::size_t>> states = { {}, { closure(pool, { 0 }) } };
-            std::size_t p = 1, j = 0;
-            while(j <= p){
-                for(char c : sigma){
-                    if(c == '\0'){
-                        continue;
-                    }
-                    std::set<std::size_t> e = DFA_edge(pool, states[j], c);
-                    bool find = false;
-                    std::size_t i;
-                    for(i = 0; i <= p; ++i){
-                        if(e == states[i]){
-                            find = true;
-                            break;
+            std::vector<std::size_t> mark(pool.size(), 0), stack;
+            for(std::size_t n = 0; n < pool.size(); ++n){
+                std::vector<std::size_t> &c = eps_closure[n];
+                c.push_back(n);
+                mark[n] = n + 1;
+                stack.push_back(n);
+                while(!stack.empty()){
+                    std::size_t s = stack.back();
+                    stack.pop_back();
+                    for(auto &i : pool[s].edge){
+                        if(i.first == '\0' && mark[i.second] != n + 1){
+                            mark[i.second] = n + 1;
+                            c.push_back(i.second);
+                            stack.push_back(i.second);
                         }
                     }
+                }
+                std::sort(c.begin(), c.end());
+            }
+        }
 
-                    auto check_ender_tokens = [&](std::size_t i){
-                        if(i > 0){
-                            trans[j].edge.push_back(std::make_pair(c, i));
-                        }
-                        for(std::size_t n : states[j]){
-                            if(pool[n].token_name){
-                                trans[j].token_name.reset(new std::string(*pool[n].token_name));
-                                trans[j].action.reset(new std::string(*pool[n].action));
-                                break;
-                            }
-                        }
-                    };
-
-                    if(find){
-                        if(trans.size() <= j){
-                            trans.resize(j + 1);
-                        }
-                        check_ender_tokens(i);
-                    }else{
-                        ++p;
-                        if(states.size() <= p){
-                            states.resize(p + 1);
-                        }
-                        states[p] = e;
-                        if(trans.size() <= j){
-                            trans.resize(j + 1);
+        // DFA states are sorted NFA node vectors, state 0 is the empty set.
+        // new states are numbered in the order they are found, visiting the
+        // chars of each state in ascending order.
+        std::vector<std::vector<std::size_t>> states = { {}, eps_closure[0] };
+        std::unordered_map<std::vector<std::size_t>, std::size_t, subset_hash> state_map;
+        state_map.insert(std::make_pair(states[0], 0));
+        state_map.insert(std::make_pair(states[1], 1));
+        node_pool trans;
+        std::vector<std::size_t> mark(pool.size(), 0);
+        std::size_t stamp = 0;
+        std::vector<std::vector<std::size_t>> move(256);
+        std::vector<char> touched;
+        for(std::size_t j = 0; j < states.size(); ++j){
+            trans.resize(j + 1);
+            for(std::size_t n : states[j]){
+                if(pool[n].token_name){
+                    trans[j].token_name.reset(new std::string(*pool[n].token_name));
+                    trans[j].action.reset(new std::string(*pool[n].action));
+                    break;
+                }
+            }
+            touched.clear();
+            for(std::size_t n : states[j]){
+                for(auto &i : pool[n].edge){
+                    if(i.first == '\0'){
+                        continue;
+                    }
+                    std::vector<std::size_t> &m = move[static_cast<unsigned char>(i.first)];
+                    if(m.empty()){
+                        touched.push_back(i.first);
+                    }
+                    m.push_back(i.second);
+                }
+            }
+            std::sort(touched.begin(), touched.end());
+            for(char c : touched){
+                std::vector<std::size_t> &m = move[static_cast<unsigned char>(c)];
+                std::vector<std::size_t> e;
+                ++stamp;
+                for(std::size_t t : m){
+                    for(std::size_t u : eps_closure[t]){
+                        if(mark[u] != stamp){
+                            mark[u] = stamp;
+                            e.push_back(u);
                         }
-                        check_ender_tokens(p);
                     }
                 }
-                ++j;
+                m.clear();
+                std::sort(e.begin(), e.end());
+                auto p = state_map.insert(std::make_pair(e, states.size()));
+                if(p.second){
+                    states.push_back(std::move(e));
+                }
+                trans[j].edge.push_back(std::make_pair(c, p.first->second));
             }
         }
         return trans;
@@ -900,13 +934,65 @@ namespace automaton{
     }
 
     void lexer::build(){
+        make_char_class();
         node_pool = automaton::NFA_to_DFA(node_pool);
         optimize();
     }
 
-    void lexer::generate_cpp(std::ostream &ofile, const std::string &lexer_namespace){
-        indent_type indent;
+    void lexer::make_char_class(){
+        // chars that take exactly the same NFA edges are equivalent. every
+        // edge is relabelled with the smallest char of its class, so
+        // NFA_to_DFA and optimize work on one char per class.
+        std::map<std::pair<std::size_t, std::size_t>, std::size_t> edge_index;
+        std::vector<std::vector<std::size_t>> signature(256);
+        for(std::size_t n = 0; n < node_pool.size(); ++n){
+            for(auto &e : node_pool[n].edge){
+                if(e.first == '\0'){
+                    continue;
+                }
+                std::size_t i = edge_index.insert(std::make_pair(std::make_pair(n, e.second), edge_index.size())).first->second;
+                signature[static_cast<unsigned char>(e.first)].push_back(i);
+            }
+        }
+        std::map<std::vector<std::size_t>, std::size_t> signature_to_class;
+        char_class.assign(256, no_class);
+        class_chars.clear();
+        for(int i = -128; i < 128; ++i){
+            char c = static_cast<char>(i);
+            std::vector<std::size_t> &sig = signature[static_cast<unsigned char>(c)];
+            if(sig.empty()){
+                continue;
+            }
+            std::sort(sig.begin(), sig.end());
+            sig.erase(std::unique(sig.begin(), sig.end()), sig.end());
+            auto p = signature_to_class.insert(std::make_pair(sig, class_chars.size()));
+            if(p.second){
+                class_chars.push_back(std::vector<char>());
+            }
+            char_class[static_cast<unsigned char>(c)] = p.first->second;
+            class_chars[p.first->second].push_back(c);
+        }
+        for(auto &node : node_pool){
+            for(auto &e : node.edge){
+                if(e.first != '\0'){
+                    e.first = class_chars[char_class[static_cast<unsigned char>(e.first)]].front();
+                }
+            }
+            std::sort(node.edge.begin(), node.edge.end());
+            node.edge.erase(std::unique(node.edge.begin(), node.edge.end()), node.edge.end());
+        }
+    }
 
+    // include guard, token_id and token_type, shared by both backends.
+    static std::string generate_cpp_head(
+        std::ostream &ofile,
+        const std::string &lexer_namespace,
+        const lexer::token_name_vector_type &token_info_vector,
+        indent_type &indent,
+        std::initializer_list<const char*> extra_includes,
+        bool simd,
+        lexer::position_policy positions
+    ){
         // include guard.
         std::string include_guard = lexer_namespace;
         std::transform(include_guard.begin(), include_guard.end(), include_guard.begin(), std::toupper);
@@ -918,6 +1004,24 @@ namespace automaton{
         ofile << indent() << "#include <memory>\n";
         ofile << indent() << "#include <vector>\n";
         ofile << indent() << "#include <exception>\n";
+        ofile << indent() << "#include <iterator>\n";
+        ofile << indent() << "#include <cstdint>\n";
+        ofile << indent() << "#include <string>\n";
+        ofile << indent() << "#include <stdexcept>\n";
+        ofile << indent() << "#include <type_traits>\n";
+        for(const char *include : extra_includes){
+            ofile << indent() << "#include <" << include << ">\n";
+        }
+        ofile << indent() << "#include <algorithm>\n";
+        ofile << indent() << "#include <cstring>\n";
+        if(simd){
+            ofile << indent() << "#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)\n";
+            ofile << indent() << "#include <immintrin.h>\n";
+            ofile << indent() << "#endif\n";
+            ofile << indent() << "#if defined(_MSC_VER)\n";
+            ofile << indent() << "#include <intrin.h>\n";
+            ofile << indent() << "#endif\n";
+        }
         ofile << indent() << "#include \"lxq.hpp\"\n\n";
 
         // enum class.
@@ -946,23 +1050,759 @@ namespace automaton{
         ofile << indent() << "using identifier_type = lxq::token_id;\n";
         ofile << indent() << "token_type() : value(nullptr){}\n";
         ofile << indent() << "token_type(const token_type&) = delete;\n";
-        ofile << indent() << "token_type(token_type &&other) : first(std::move(other.first)), last(std::move(other.last)), line_num(other.line_num), char_num(other.line_num), word_num(other.word_num), identifier(other.identifier), value(std::move(other.value)){}\n";
+        ofile << indent() << "token_type(token_type &&other) : first(std::move(other.first)), last(std::move(other.last)), line_num(other.line_num), char_num(other.char_num), word_num(other.word_num), identifier(other.identifier), value(std::move(other.value)){}\n";
+        ofile << indent() << "token_type &operator =(token_type &&other){\n";
+        ++indent;
+        ofile << indent() << "first = std::move(other.first);\n";
+        ofile << indent() << "last = std::move(other.last);\n";
+        ofile << indent() << "line_num = other.line_num;\n";
+        ofile << indent() << "char_num = other.char_num;\n";
+        ofile << indent() << "word_num = other.word_num;\n";
+        ofile << indent() << "identifier = other.identifier;\n";
+        ofile << indent() << "value = std::move(other.value);\n";
+        ofile << indent() << "return *this;\n";
+        --indent;
+        ofile << indent() << "}\n";
         ofile << indent() << "~token_type() = default;\n";
         ofile << indent() << "Iter first, last;\n";
         ofile << indent() << "std::size_t line_num, char_num, word_num;\n";
         ofile << indent() << "identifier_type identifier;\n";
-        ofile << indent() << "std::unique_ptr<lxq::semantic_data> value;\n";
+        ofile << indent() << "lxq::value_ptr value;\n";
         --indent;
         ofile << indent() << "};\n\n";
 
-        // tokenize function.
-        ofile << indent() << "template<class Action>\n";
-        ofile << indent() << "static std::vector<token_type> tokenize(Iter iter, Iter end, Action &action){\n";
+        ofile << R"(    // iterators whose bytes can be read through a const char*.
+    using contiguous_iterator = std::integral_constant<bool,
+        std::is_same<Iter, const char*>::value || std::is_same<Iter, char*>::value ||
+        std::is_same<Iter, std::string::const_iterator>::value || std::is_same<Iter, std::string::iterator>::value ||
+        std::is_same<Iter, typename std::vector<char>::const_iterator>::value || std::is_same<Iter, typename std::vector<char>::iterator>::value
+    >;
+
+)";
+        if(positions == lexer::position_policy::lazy){
+            ofile << R"(    // line and char numbers of the lazy position policy, computed on demand
+    // from the offsets of the newlines. word numbers are not kept.
+    class line_index{
+    public:
+        line_index(Iter first, Iter last) : first(first){
+            build(first, last, contiguous_iterator());
+        }
+
+        // line_num and char_num as the eager policy counts them at pos.
+        std::pair<std::size_t, std::size_t> position(Iter pos) const{
+            std::size_t offset = std::distance(first, pos);
+            std::size_t line = std::lower_bound(newline.begin(), newline.end(), offset) - newline.begin();
+            return std::make_pair(line, line == 0 ? offset : offset - newline[line - 1]);
+        }
+
+    private:
+        void build(Iter iter, Iter last, std::true_type){
+            if(iter == last){
+                return;
+            }
+            const char *begin = &*iter, *p = begin, *end = begin + (last - iter);
+            while(const void *q = std::memchr(p, '\n', end - p)){
+                p = static_cast<const char*>(q);
+                newline.push_back(p - begin);
+                ++p;
+            }
+        }
+
+        void build(Iter iter, Iter last, std::false_type){
+            for(std::size_t offset = 0; iter != last; ++iter, ++offset){
+                if(*iter == '\n'){
+                    newline.push_back(offset);
+                }
+            }
+        }
+
+        Iter first;
+        std::vector<std::size_t> newline;
+    };
+
+)";
+        }
+        return include_guard;
+    }
+
+    // where a finished token goes and where its text lies.
+    enum class token_sink{
+        // returned from stream::next_token, the text is [first, iter).
+        stream,
+        // passed to the sink of push_stream::feed, the text is the spill
+        // followed by [first, iter) of the chunk.
+        push,
+        // passed to the sink of push_stream::finish, [first, iter) is the spill.
+        finish
+    };
+
+    static void generate_cpp_deliver_token(std::ostream &ofile, indent_type &indent, token_sink sink){
+        if(sink == token_sink::stream){
+            ofile << indent() << "return t;\n";
+        }else{
+            ofile << indent() << "sink(std::move(t));\n";
+        }
+    }
+
+    // the end token once the input is exhausted.
+    static void generate_cpp_end_token(std::ostream &ofile, indent_type &indent, token_sink sink){
+        ofile << indent() << "{\n";
+        ++indent;
+        ofile << indent() << "token_type t;\n";
+        ofile << indent() << "t.first = iter;\n";
+        ofile << indent() << "t.last = iter;\n";
+        ofile << indent() << "t.line_num = 0;\n";
+        ofile << indent() << "t.char_num = 0;\n";
+        ofile << indent() << "t.word_num = 0;\n";
+        ofile << indent() << "t.identifier = token_type::identifier_type::end;\n";
+        generate_cpp_deliver_token(ofile, indent, sink);
+        --indent;
+        ofile << indent() << "}\n";
+    }
+
+    // the token finished by an accepting state.
+    static void generate_cpp_push_token(std::ostream &ofile, indent_type &indent, const std::string &token_name, const std::string &action, token_sink sink, bool count){
+        const char *first = "first", *last = "iter";
+        if(sink == token_sink::push){
+            ofile << indent() << "Iter tf = first, tl = iter;\n";
+            ofile << indent() << "if(!spill.empty()){\n";
+            ++indent;
+            ofile << indent() << "spill.append(first, iter);\n";
+            ofile << indent() << "tf = spill.data();\n";
+            ofile << indent() << "tl = tf + spill.size();\n";
+            --indent;
+            ofile << indent() << "}\n";
+            first = "tf";
+            last = "tl";
+        }
+        ofile << indent() << "token_type t;\n";
+        ofile << indent() << "t.first = " << first << ";\n";
+        ofile << indent() << "t.last = " << last << ";\n";
+        if(count){
+            ofile << indent() << "t.line_num = line_num;\n";
+            ofile << indent() << "t.char_num = char_num;\n";
+            ofile << indent() << "t.word_num = word_num++;\n";
+        }else{
+            ofile << indent() << "t.line_num = 0;\n";
+            ofile << indent() << "t.char_num = 0;\n";
+            ofile << indent() << "t.word_num = 0;\n";
+        }
+        ofile << indent() << "t.identifier = token_type::identifier_type::" << token_name << ";\n";
+        if(action.size() > 0){
+            ofile << indent() << "t.value = lxq::own(allocator, lxq::apply(allocator, [&](auto &...alloc){ return action." << action << "(alloc..., " << first << ", " << last << "); }));\n";
+        }
+        generate_cpp_deliver_token(ofile, indent, sink);
+    }
+
+    // the pull lexer class up to the body of next_token.
+    static void generate_cpp_stream_head(std::ostream &ofile, indent_type &indent){
+        ofile << indent() << "// pull lexer, only the positions between two tokens are kept. the\n";
+        ofile << indent() << "// allocator is the lxq::arena with an arena policy.\n";
+        ofile << indent() << "template<class Action, class Allocator = lxq::heap>\n";
+        ofile << indent() << "class stream{\n";
+        ofile << indent() << "public:\n";
+        ++indent;
+        ofile << indent() << "stream(Iter iter, Iter end, Action &action, Allocator *allocator = nullptr) : iter(iter), end(end), action(action), allocator(allocator){}\n\n";
+        ofile << indent() << "// the next token, the end token once the input is exhausted.\n";
+        ofile << indent() << "token_type next_token(){\n";
+        ++indent;
+    }
+
+    // the rest of the pull lexer, its input iterator and tokenize.
+    static void generate_cpp_stream_tail(std::ostream &ofile, indent_type &indent, bool count){
+        --indent;
+        ofile << indent() << "}\n\n";
+        --indent;
+        ofile << indent() << "private:\n";
+        ++indent;
+        ofile << indent() << "Iter iter, end;\n";
+        ofile << indent() << "Action &action;\n";
+        ofile << indent() << "Allocator *allocator;\n";
+        if(count){
+            ofile << indent() << "std::size_t line_num = 0, char_num = 0, word_num = 0;\n";
+        }
+        --indent;
+        ofile << indent() << "};\n\n";
+
+        ofile << R"(    // input iterator over a stream, the default constructed one is past the end token.
+    template<class Action, class Allocator = lxq::heap>
+    class stream_iterator{
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = token_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = token_type*;
+        using reference = token_type&;
+
+        stream_iterator() = default;
+        stream_iterator(stream<Action, Allocator> &s) : s(&s), current(std::make_shared<token_type>(s.next_token())){}
+
+        token_type &operator *() const{
+            return *current;
+        }
+
+        token_type *operator ->() const{
+            return current.get();
+        }
+
+        stream_iterator &operator ++(){
+            if(current->identifier == lxq::token_id::end){
+                s = nullptr;
+                current.reset();
+            }else{
+                *current = s->next_token();
+            }
+            return *this;
+        }
+
+        bool operator ==(const stream_iterator &other) const{
+            return s == other.s;
+        }
+
+        bool operator !=(const stream_iterator &other) const{
+            return s != other.s;
+        }
+
+    private:
+        stream<Action, Allocator> *s = nullptr;
+        std::shared_ptr<token_type> current;
+    };
+
+    template<class Action>
+    static std::vector<token_type> tokenize(Iter iter, Iter end, Action &action){
+        std::vector<token_type> result;
+        tokenize(iter, end, action, std::back_inserter(result));
+        return result;
+    }
+
+    // writes the tokens up to and including the end token to out.
+    template<class Action, class OutputIter>
+    static OutputIter tokenize(Iter iter, Iter end, Action &action, OutputIter out){
+        return drain(stream<Action>(iter, end, action), out);
+    }
+
+    // arena policy, the actions get the arena as their first argument.
+    template<class Action>
+    static std::vector<token_type> tokenize(Iter iter, Iter end, Action &action, lxq::arena &arena){
+        std::vector<token_type> result;
+        tokenize(iter, end, action, arena, std::back_inserter(result));
+        return result;
+    }
+
+    template<class Action, class OutputIter>
+    static OutputIter tokenize(Iter iter, Iter end, Action &action, lxq::arena &arena, OutputIter out){
+        return drain(stream<Action, lxq::arena>(iter, end, action, &arena), out);
+    }
+
+    // writes the tokens of s up to and including the end token to out.
+    template<class Stream, class OutputIter>
+    static OutputIter drain(Stream &&s, OutputIter out){
+        while(true){
+            token_type t = s.next_token();
+            bool at_end = t.identifier == lxq::token_id::end;
+            *out++ = std::move(t);
+            if(at_end){
+                return out;
+            }
+        }
+    }
+
+#if defined(__cpp_impl_coroutine)
+    // coroutine flavour of tokenize, yields the tokens one at a time up to
+    // and including the end token.
+    template<class Action>
+    static lxq::generator<token_type> tokens(Iter iter, Iter end, Action &action){
+        stream<Action> s(iter, end, action);
+        while(true){
+            token_type t = s.next_token();
+            bool at_end = t.identifier == lxq::token_id::end;
+            co_yield std::move(t);
+            if(at_end){
+                co_return;
+            }
+        }
+    }
+#endif
+
+    // tokens as parallel arrays of ids, 32 bit offsets and lengths from the
+    // start of the input, and handles of the semantic values, 0 for none.
+    // it is filled by tokenize(iter, end, action, std::back_inserter(buffer))
+    // and read by the parser through begin() and end(), which moves the
+    // semantic values out. the iterator walks the input once along the
+    // offsets, and recounts the positions on the way when the lexer counts
+    // them.
+    class token_buffer{
+    public:
+        using value_type = token_type;
+
+        class iterator{
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = token_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = token_type*;
+            using reference = token_type&;
+
+            iterator() = default;
+            iterator(token_buffer &buffer, std::size_t i) : buffer(&buffer), i(i), pos(buffer.first){
+                if(i < buffer.size()){
+                    current = std::make_shared<token_type>();
+                    load();
+                }
+            }
+
+            token_type &operator *() const{
+                return *current;
+            }
+
+            token_type *operator ->() const{
+                return current.get();
+            }
+
+            iterator &operator ++(){
+                if(++i < buffer->size()){
+                    load();
+                }
+                return *this;
+            }
+
+            bool operator ==(const iterator &other) const{
+                return i == other.i;
+            }
+
+            bool operator !=(const iterator &other) const{
+                return i != other.i;
+            }
+
+        private:
+            void load(){
+                token_type &t = *current;
+                t.first = advance(buffer->offset[i]);
+                t.last = advance(buffer->offset[i] + buffer->length[i]);
+)";
+        if(count){
+            ofile << R"(                if(buffer->id[i] == lxq::token_id::end){
+                    t.line_num = 0;
+                    t.char_num = 0;
+                    t.word_num = 0;
+                }else{
+                    t.line_num = line_num;
+                    t.char_num = char_num;
+                    t.word_num = word_num++;
+                }
+)";
+        }else{
+            ofile << R"(                t.line_num = 0;
+                t.char_num = 0;
+                t.word_num = 0;
+)";
+        }
+        ofile << R"(                t.identifier = buffer->id[i];
+                if(buffer->handle[i] != 0){
+                    t.value = std::move(buffer->value[buffer->handle[i] - 1]);
+                }else{
+                    t.value.reset();
+                }
+            }
+
+)";
+        if(count){
+            ofile << R"(            // moves pos forward to offset o, counting as the lexer does.
+            Iter advance(std::size_t o){
+                for(; at < o; ++at, ++pos){
+                    if(*pos == '\n'){
+                        char_num = 0;
+                        word_num = 0;
+                        ++line_num;
+                    }
+                    ++char_num;
+                }
+                return pos;
+            }
+
+            token_buffer *buffer = nullptr;
+            std::size_t i = 0;
+            Iter pos;
+            std::size_t at = 0, line_num = 0, char_num = 0, word_num = 0;
+            std::shared_ptr<token_type> current;
+        };
+)";
+        }else{
+            ofile << R"(            // moves pos forward to offset o.
+            Iter advance(std::size_t o){
+                std::advance(pos, o - at);
+                at = o;
+                return pos;
+            }
+
+            token_buffer *buffer = nullptr;
+            std::size_t i = 0;
+            Iter pos;
+            std::size_t at = 0;
+            std::shared_ptr<token_type> current;
+        };
+)";
+        }
+        ofile << R"(
+        token_buffer(Iter first) : first(first), tail(first){}
+
+        // the tokens come in input order, so the offset is counted from the
+        // end of the previous one.
+        void push_back(token_type &&t){
+            std::size_t o = tail_offset + std::distance(tail, t.first), n = std::distance(t.first, t.last);
+            if(o + n > UINT32_MAX){
+                throw std::runtime_error("token_buffer : the input exceeds 4 GiB.");
+            }
+            tail = t.last;
+            tail_offset = o + n;
+            id.push_back(t.identifier);
+            offset.push_back(static_cast<std::uint32_t>(o));
+            length.push_back(static_cast<std::uint32_t>(n));
+            if(t.value){
+                value.push_back(std::move(t.value));
+                handle.push_back(static_cast<std::uint32_t>(value.size()));
+            }else{
+                handle.push_back(0);
+            }
+        }
+
+        std::size_t size() const{
+            return id.size();
+        }
+
+        iterator begin(){
+            return iterator(*this, 0);
+        }
+
+        iterator end(){
+            return iterator(*this, size());
+        }
+
+        Iter first;
+        std::vector<lxq::token_id> id;
+        std::vector<std::uint32_t> offset, length, handle;
+        std::vector<lxq::value_ptr> value;
+
+    private:
+        Iter tail;
+        std::size_t tail_offset = 0;
+    };
+
+)";
+    }
+
+    // the push lexer class up to the body of feed.
+    static void generate_cpp_push_head(std::ostream &ofile, indent_type &indent){
+        ofile << R"(    // push lexer, fed the input chunk by chunk. a token goes to the sink as
+    // soon as it is complete. its text points into the chunk, or into the
+    // spill buffer when it straddles chunks, and is valid only during the
+    // sink call.
+    template<class Action, class Allocator = lxq::heap>
+    class push_stream{
+        static_assert(std::is_same<Iter, const char*>::value, "push_stream needs Iter = const char*.");
+
+    public:
+        push_stream(Action &action, Allocator *allocator = nullptr) : action(action), allocator(allocator){}
+
+        template<class Sink>
+        void feed(Iter iter, Iter end, Sink sink){
+)";
+        ++indent;
         ++indent;
-        ofile << indent() << "std::vector<token_type> result;\n";
         ofile << indent() << "Iter first = iter;\n";
-        ofile << indent() << "std::size_t line_num = 0, char_num = 0, word_num = 0;\n";
         ofile << indent() << "char c;\n\n";
+    }
+
+    // the end of feed up to the body of finish.
+    static void generate_cpp_push_middle(std::ostream &ofile, indent_type &indent){
+        --indent;
+        ofile << indent() << "}\n\n";
+        ofile << indent() << "// passes the pending token, then the end token to sink.\n";
+        ofile << indent() << "template<class Sink>\n";
+        ofile << indent() << "void finish(Sink sink){\n";
+        ++indent;
+        ofile << indent() << "Iter first = spill.data(), iter = first + spill.size();\n";
+    }
+
+    // the rest of the push lexer.
+    static void generate_cpp_push_tail(std::ostream &ofile, indent_type &indent, bool count){
+        generate_cpp_end_token(ofile, indent, token_sink::finish);
+        ofile << indent() << "spill.clear();\n";
+        ofile << indent() << "state = 1;\n";
+        --indent;
+        ofile << indent() << "}\n\n";
+        ofile << indent() << "// bytes of the partial token held over to the next feed.\n";
+        ofile << indent() << "std::size_t spilled() const{\n";
+        ++indent;
+        ofile << indent() << "return spill.size();\n";
+        --indent;
+        ofile << indent() << "}\n\n";
+        --indent;
+        ofile << indent() << "private:\n";
+        ++indent;
+        ofile << indent() << "Action &action;\n";
+        ofile << indent() << "Allocator *allocator;\n";
+        ofile << indent() << "std::string spill;\n";
+        if(count){
+            ofile << indent() << "std::size_t state = 1, line_num = 0, char_num = 0, word_num = 0;\n";
+        }else{
+            ofile << indent() << "std::size_t state = 1;\n";
+        }
+        --indent;
+        ofile << indent() << "};\n";
+    }
+
+    // the narrowest unsigned type holding max.
+    static const char *generate_cpp_uint_type(std::size_t max){
+        if(max <= 0xff){
+            return "std::uint8_t";
+        }else if(max <= 0xffff){
+            return "std::uint16_t";
+        }else{
+            return "std::uint32_t";
+        }
+    }
+
+    static void generate_cpp_array(std::ostream &ofile, indent_type &indent, const std::string &name, const std::vector<std::size_t> &v){
+        std::size_t max = 0;
+        for(std::size_t n : v){
+            max = (std::max)(max, n);
+        }
+        ofile << indent() << "static constexpr " << generate_cpp_uint_type(max) << " " << name << "[" << v.size() << "] = {\n";
+        ++indent;
+        for(std::size_t i = 0; i < v.size(); ++i){
+            ofile << (i % 16 == 0 ? indent() : "") << v[i] << (i + 1 < v.size() ? "," : "") << ((i + 1) % 16 == 0 || i + 1 == v.size() ? "\n" : " ");
+        }
+        --indent;
+        ofile << indent() << "};\n";
+    }
+
+    // the run skipping kernels of the goto backend. a run is the byte set a
+    // state loops on, given as ranges or as the few bytes that end it. the
+    // SIMD width is picked at compile time.
+    static void generate_cpp_run_kernels(std::ostream &ofile){
+        ofile << R"(    static unsigned int count_trailing_zeros(unsigned int bits){
+#if defined(_MSC_VER)
+        unsigned long n;
+        _BitScanForward(&n, bits);
+        return n;
+#else
+        return __builtin_ctz(bits);
+#endif
+    }
+
+    // the bytes in N [lo, hi] ranges.
+    template<std::size_t N>
+    struct run_ranges{
+        unsigned char range[N][2];
+
+        bool operator ()(unsigned char c) const{
+            for(std::size_t i = 0; i < N; ++i){
+                if(static_cast<unsigned char>(c - range[i][0]) <= static_cast<unsigned char>(range[i][1] - range[i][0])){
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // the first byte of [p, end) out of the run.
+        const char *skip(const char *p, const char *end) const{
+#if defined(__AVX2__)
+            while(end - p >= 32){
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), m = _mm256_setzero_si256();
+                for(std::size_t i = 0; i < N; ++i){
+                    __m256i k = _mm256_set1_epi8(static_cast<char>(range[i][1] - range[i][0]));
+                    __m256i t = _mm256_sub_epi8(x, _mm256_set1_epi8(static_cast<char>(range[i][0])));
+                    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(_mm256_max_epu8(t, k), k));
+                }
+                unsigned int bits = ~static_cast<unsigned int>(_mm256_movemask_epi8(m));
+                if(bits != 0){
+                    return p + count_trailing_zeros(bits);
+                }
+                p += 32;
+            }
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+            while(end - p >= 16){
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), m = _mm_setzero_si128();
+                for(std::size_t i = 0; i < N; ++i){
+                    __m128i k = _mm_set1_epi8(static_cast<char>(range[i][1] - range[i][0]));
+                    __m128i t = _mm_sub_epi8(x, _mm_set1_epi8(static_cast<char>(range[i][0])));
+                    m = _mm_or_si128(m, _mm_cmpeq_epi8(_mm_max_epu8(t, k), k));
+                }
+                unsigned int bits = ~static_cast<unsigned int>(_mm_movemask_epi8(m)) & 0xffff;
+                if(bits != 0){
+                    return p + count_trailing_zeros(bits);
+                }
+                p += 16;
+            }
+#endif
+            while(p != end && (*this)(*p)){
+                ++p;
+            }
+            return p;
+        }
+    };
+
+    // every byte but N stop bytes, as the body of a string or a comment.
+    template<std::size_t N>
+    struct run_stops{
+        unsigned char stop[N];
+
+        bool operator ()(unsigned char c) const{
+            for(std::size_t i = 0; i < N; ++i){
+                if(c == stop[i]){
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // the first stop byte of [p, end), or end.
+        const char *skip(const char *p, const char *end) const{
+            if(N == 1){
+                const void *q = std::memchr(p, stop[0], end - p);
+                return q ? static_cast<const char*>(q) : end;
+            }
+#if defined(__AVX2__)
+            while(end - p >= 32){
+                __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), m = _mm256_setzero_si256();
+                for(std::size_t i = 0; i < N; ++i){
+                    m = _mm256_or_si256(m, _mm256_cmpeq_epi8(x, _mm256_set1_epi8(static_cast<char>(stop[i]))));
+                }
+                unsigned int bits = static_cast<unsigned int>(_mm256_movemask_epi8(m));
+                if(bits != 0){
+                    return p + count_trailing_zeros(bits);
+                }
+                p += 32;
+            }
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+            while(end - p >= 16){
+                __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), m = _mm_setzero_si128();
+                for(std::size_t i = 0; i < N; ++i){
+                    m = _mm_or_si128(m, _mm_cmpeq_epi8(x, _mm_set1_epi8(static_cast<char>(stop[i]))));
+                }
+                unsigned int bits = static_cast<unsigned int>(_mm_movemask_epi8(m));
+                if(bits != 0){
+                    return p + count_trailing_zeros(bits);
+                }
+                p += 16;
+            }
+#endif
+            while(p != end && (*this)(*p)){
+                ++p;
+            }
+            return p;
+        }
+    };
+
+    // consumes the run at iter.
+    template<class Run>
+    static Iter skip_run(Iter iter, Iter end, const Run &run){
+        return skip_run(iter, end, run, contiguous_iterator());
+    }
+
+    template<class Run>
+    static Iter skip_run(Iter iter, Iter end, const Run &run, std::true_type){
+        if(iter == end){
+            return iter;
+        }
+        const char *first = &*iter;
+        return iter + (run.skip(first, first + (end - iter)) - first);
+    }
+
+    template<class Run>
+    static Iter skip_run(Iter iter, Iter end, const Run &run, std::false_type){
+        while(iter != end && run(*iter)){
+            ++iter;
+        }
+        return iter;
+    }
+
+    // consumes the run at iter and counts it as the byte by byte transitions
+    // would.
+    template<class Run>
+    static Iter skip_run(Iter iter, Iter end, const Run &run, std::size_t &line_num, std::size_t &char_num, std::size_t &word_num){
+        return skip_run(iter, end, run, line_num, char_num, word_num, contiguous_iterator());
+    }
+
+    template<class Run>
+    static Iter skip_run(Iter iter, Iter end, const Run &run, std::size_t &line_num, std::size_t &char_num, std::size_t &word_num, std::true_type){
+        if(iter == end){
+            return iter;
+        }
+        const char *first = &*iter, *last = run.skip(first, first + (end - iter));
+        std::size_t lines = run('\n') ? std::count(first, last, '\n') : 0;
+        if(lines > 0){
+            std::reverse_iterator<const char*> nl = std::find(std::reverse_iterator<const char*>(last), std::reverse_iterator<const char*>(first), '\n');
+            line_num += lines;
+            word_num = 0;
+            char_num = last - nl.base() + 1;
+        }else{
+            char_num += last - first;
+        }
+        return iter + (last - first);
+    }
+
+    template<class Run>
+    static Iter skip_run(Iter iter, Iter end, const Run &run, std::size_t &line_num, std::size_t &char_num, std::size_t &word_num, std::false_type){
+        for(; iter != end && run(*iter); ++iter){
+            if(*iter == '\n'){
+                char_num = 0;
+                word_num = 0;
+                ++line_num;
+            }
+            ++char_num;
+        }
+        return iter;
+    }
+
+)";
+    }
+
+    // states from which every token that can still be finished is dropped.
+    // the push lexer keeps no text for a partial token in such a state.
+    std::vector<bool> lexer::drop_only_states() const{
+        std::vector<bool> emits(node_pool.size(), false);
+        for(bool changed = true; changed; ){
+            changed = false;
+            for(std::size_t i = 1; i < node_pool.size(); ++i){
+                if(emits[i] || unused_node_set.find(i) != unused_node_set.end()){
+                    continue;
+                }
+                bool e = node_pool[i].token_name && *node_pool[i].action != "drop";
+                for(auto &j : node_pool[i].edge){
+                    e = e || emits[j.second];
+                }
+                if(e){
+                    emits[i] = true;
+                    changed = true;
+                }
+            }
+        }
+        std::vector<bool> drop_only(node_pool.size());
+        for(std::size_t i = 0; i < node_pool.size(); ++i){
+            drop_only[i] = !emits[i];
+        }
+        return drop_only;
+    }
+
+    // one labelled block per state. the pull lexer runs from state_1 to the
+    // end of one token, the push lexer suspends in any state at the end of
+    // the chunk.
+    void lexer::generate_cpp_goto_states(std::ostream &ofile, indent_type &indent, bool push, bool count){
+        token_sink sink = push ? token_sink::push : token_sink::stream;
+        std::vector<bool> drop_only = drop_only_states();
+        if(push){
+            ofile << indent() << "switch(state){\n";
+            for(std::size_t i = 1; i < node_pool.size(); ++i){
+                if(unused_node_set.find(i) == unused_node_set.end()){
+                    ofile << indent() << "case " << i << ": goto state_" << i << ";\n";
+                }
+            }
+            ofile << indent() << "}\n\n";
+        }
 
         for(std::size_t i = 1; i < node_pool.size(); ++i){
             if(unused_node_set.find(i) != unused_node_set.end()){
@@ -972,15 +1812,73 @@ namespace automaton{
             std::map<std::size_t, std::set<int>> edge_inv_map;
             std::map<std::size_t, std::set<int>> other_edge_inv_map;
             for(auto &j : node_pool[i].edge){
-                if(j.first >= -128 && j.first <= 127){
-                    edge_inv_map[j.second].insert(j.first);
-                }else{
-                    other_edge_inv_map[j.second].insert(j.first);
+                for(char c : class_chars[char_class[static_cast<unsigned char>(j.first)]]){
+                    if(c >= -128 && c <= 127){
+                        edge_inv_map[j.second].insert(c);
+                    }else{
+                        other_edge_inv_map[j.second].insert(c);
+                    }
                 }
             }
 
             ofile << indent() << "state_" << i << ":;\n";
-            if(i == 1){
+
+            // a self loop is consumed as a run, found by its stop bytes when
+            // at most 3 bytes leave it, or else by at most 4 byte ranges.
+            std::vector<bool> loop(256, false);
+            std::size_t loop_count = 0;
+            for(auto &j : node_pool[i].edge){
+                if(j.second != i){
+                    continue;
+                }
+                for(char c : class_chars[char_class[static_cast<unsigned char>(j.first)]]){
+                    loop[static_cast<unsigned char>(c)] = true;
+                    ++loop_count;
+                }
+            }
+            std::vector<int> stop;
+            std::vector<std::pair<int, int>> range;
+            for(int c = 0; c < 256; ++c){
+                if(!loop[c]){
+                    stop.push_back(c);
+                }else if(!range.empty() && range.back().second + 1 == c){
+                    range.back().second = c;
+                }else{
+                    range.push_back(std::make_pair(c, c));
+                }
+            }
+            if(loop_count > 0 && !stop.empty() && stop.size() <= 3){
+                ofile << indent() << "{\n";
+                ++indent;
+                ofile << indent() << "static const run_stops<" << stop.size() << "> run = { {";
+                for(std::size_t k = 0; k < stop.size(); ++k){
+                    ofile << (k > 0 ? ", " : " ") << stop[k];
+                }
+                ofile << " } };\n";
+                ofile << indent() << (count ? "iter = skip_run(iter, end, run, line_num, char_num, word_num);\n" : "iter = skip_run(iter, end, run);\n");
+                --indent;
+                ofile << indent() << "}\n";
+            }else if(loop_count > 0 && range.size() <= 4){
+                ofile << indent() << "{\n";
+                ++indent;
+                ofile << indent() << "static const run_ranges<" << range.size() << "> run = { {";
+                for(std::size_t k = 0; k < range.size(); ++k){
+                    ofile << (k > 0 ? ", " : " ") << "{ " << range[k].first << ", " << range[k].second << " }";
+                }
+                ofile << " } };\n";
+                ofile << indent() << (count ? "iter = skip_run(iter, end, run, line_num, char_num, word_num);\n" : "iter = skip_run(iter, end, run);\n");
+                --indent;
+                ofile << indent() << "}\n";
+            }
+            if(push){
+                ofile << indent() << "if(iter == end){\n";
+                ++indent;
+                ofile << indent() << "state = " << i << ";\n";
+                ofile << indent() << (drop_only[i] ? "spill.clear();\n" : "spill.append(first, iter);\n");
+                ofile << indent() << "return;\n";
+                --indent;
+                ofile << indent() << "}\n";
+            }else if(i == 1){
                 ofile << indent() << "if(iter == end){\n";
                 ++indent;
                 ofile << indent() << "goto end_of_tokenize;\n";
@@ -990,19 +1888,10 @@ namespace automaton{
                 ofile << indent() << "if(iter == end){\n";
                 ++indent;
                 if(*node_pool[i].action != "drop"){
-                    ofile << indent() << "token_type t;\n";
-                    ofile << indent() << "t.first = first;\n";
-                    ofile << indent() << "t.last = iter;\n";
-                    ofile << indent() << "t.line_num = line_num;\n";
-                    ofile << indent() << "t.char_num = char_num;\n";
-                    ofile << indent() << "t.word_num = word_num++;\n";
-                    ofile << indent() << "t.identifier = token_type::identifier_type::" << *node_pool[i].token_name << ";\n";
-                    if(node_pool[i].action->size() > 0){
-                        ofile << indent() << "t.value = std::move(std::unique_ptr<lxq::semantic_data>(action." << *node_pool[i].action << "(first, iter)));\n";
-                    }
-                    ofile << indent() << "result.push_back(std::move(t));\n";
+                    generate_cpp_push_token(ofile, indent, *node_pool[i].token_name, *node_pool[i].action, sink, count);
+                }else{
+                    ofile << indent() << "goto end_of_tokenize;\n";
                 }
-                ofile << indent() << "goto end_of_tokenize;\n";
                 --indent;
                 ofile << indent() << "}\n";
             }else{
@@ -1024,13 +1913,13 @@ namespace automaton{
                             nline = true;
                         }
                         std::string str = std::to_string(*kter);
-                        ofile << (k % 8 == 0 ? indent() : "") << "case " << [](std::size_t n){ std::string s; for(std::size_t i = 0; i < 3 - n; ++i){ s += " "; } return s; }(str.size()) << str << ((k + 1) % 8 == 0 ? ":\n" : ": ");
+                        ofile << (k % 8 == 0 ? indent() : "") << "case " << [](std::size_t n){ std::string s; for(std::size_t i = n; i < 3; ++i){ s += " "; } return s; }(str.size()) << str << ((k + 1) % 8 == 0 ? ":\n" : ": ");
                     }
                     if((j.second.size()) % 8 != 0){
                         ofile << "\n";
                     }
                     ++indent;
-                    if(nline){
+                    if(nline && count){
                         if(j.second.size() > 1){
                             ofile << indent() << "if(c == " << static_cast<int>('\n') << "){\n";
                             ++indent;
@@ -1045,7 +1934,9 @@ namespace automaton{
                             ofile << indent() << "}\n";
                         }
                     }
-                    ofile << indent() << "++char_num;\n";
+                    if(count){
+                        ofile << indent() << "++char_num;\n";
+                    }
                     ofile << indent() << "++iter;\n";
                     ofile << indent() << "goto state_" << j.first << ";\n";
                     --indent;
@@ -1059,43 +1950,323 @@ namespace automaton{
                 ofile << indent() << "{\n";
                 ++indent;
                 if(*node_pool[i].action != "drop"){
-                    ofile << indent() << "token_type t;\n";
-                    ofile << indent() << "t.first = first;\n";
-                    ofile << indent() << "t.last = iter;\n";
-                    ofile << indent() << "t.line_num = line_num;\n";
-                    ofile << indent() << "t.char_num = char_num;\n";
-                    ofile << indent() << "t.word_num = word_num++;\n";
-                    ofile << indent() << "t.identifier = token_type::identifier_type::" << *node_pool[i].token_name << ";\n";
-                    if(node_pool[i].action->size() > 0){
-                        ofile << indent() << "t.value = std::move(std::unique_ptr<lxq::semantic_data>(action." << *node_pool[i].action << "(first, iter)));\n";
-                    }
-                    ofile << indent() << "result.push_back(std::move(t));\n";
+                    generate_cpp_push_token(ofile, indent, *node_pool[i].token_name, *node_pool[i].action, sink, count);
+                }
+                if(push){
+                    ofile << indent() << "spill.clear();\n";
+                }
+                if(push || *node_pool[i].action == "drop"){
+                    ofile << indent() << "first = iter;\n";
+                    ofile << indent() << "goto state_1;\n";
                 }
-                ofile << indent() << "first = iter;\n";
-                ofile << indent() << "goto state_1;\n";
                 --indent;
                 ofile << indent() << "}\n\n";
             }else{
                 ofile << indent() << "throw std::runtime_error(\"lexical error : state " << i << "\");\n\n";
             }
         }
+    }
+
+    void lexer::generate_cpp(std::ostream &ofile, const std::string &lexer_namespace, position_policy positions){
+        indent_type indent;
+        bool count = positions == position_policy::eager;
+        std::string include_guard = generate_cpp_head(ofile, lexer_namespace, token_info_vector, indent, {}, true, positions);
+        generate_cpp_run_kernels(ofile);
 
+        // next_token function.
+        generate_cpp_stream_head(ofile, indent);
+        ofile << indent() << "Iter first = iter;\n";
+        ofile << indent() << "char c;\n\n";
+        generate_cpp_goto_states(ofile, indent, false, count);
         ofile << indent() << "end_of_tokenize:;\n";
-        ofile << indent() << "{\n";
+        generate_cpp_end_token(ofile, indent, token_sink::stream);
+        generate_cpp_stream_tail(ofile, indent, count);
+
+        // feed and finish functions.
+        generate_cpp_push_head(ofile, indent);
+        generate_cpp_goto_states(ofile, indent, true, count);
+        generate_cpp_push_middle(ofile, indent);
+        std::map<std::pair<std::string, std::string>, std::vector<std::size_t>> accept_states;
+        for(std::size_t i = 2; i < node_pool.size(); ++i){
+            if(unused_node_set.find(i) == unused_node_set.end() && node_pool[i].token_name){
+                accept_states[std::make_pair(*node_pool[i].token_name, *node_pool[i].action)].push_back(i);
+            }
+        }
+        ofile << indent() << "switch(state){\n";
+        ofile << indent() << "case 1:\n";
         ++indent;
-        ofile << indent() << "token_type t;\n";
-        ofile << indent() << "t.first = iter;\n";
-        ofile << indent() << "t.last = iter;\n";
-        ofile << indent() << "t.line_num = 0;\n";
-        ofile << indent() << "t.char_num = 0;\n";
-        ofile << indent() << "t.word_num = 0;\n";
-        ofile << indent() << "t.identifier = token_type::identifier_type::end;\n";
-        ofile << indent() << "result.push_back(std::move(t));\n";
+        ofile << indent() << "break;\n\n";
+        --indent;
+        for(auto &kind : accept_states){
+            for(std::size_t i : kind.second){
+                ofile << indent() << "case " << i << ":\n";
+            }
+            ++indent;
+            if(kind.first.second != "drop"){
+                ofile << indent() << "{\n";
+                ++indent;
+                generate_cpp_push_token(ofile, indent, kind.first.first, kind.first.second, token_sink::finish, count);
+                --indent;
+                ofile << indent() << "}\n";
+            }
+            ofile << indent() << "break;\n\n";
+            --indent;
+        }
+        ofile << indent() << "default:\n";
+        ++indent;
+        ofile << indent() << "throw std::runtime_error(\"lexical error : state \" + std::to_string(state));\n";
         --indent;
         ofile << indent() << "}\n";
-        ofile << indent() << "return result;\n";
+        generate_cpp_push_tail(ofile, indent, count);
+        --indent;
+        ofile << indent() << "};\n";
+
+        // end of include guard.
+        ofile << indent() << "#endif // " << include_guard << "\n\n";
+    }
+
+    // switch on the accept kind of state, for the table backend.
+    static void generate_cpp_accept_switch(std::ostream &ofile, indent_type &indent, const std::vector<std::pair<std::string, std::string>> &accept_kind, token_sink sink, bool count){
+        ofile << indent() << "switch(accept(state)){\n";
+        ofile << indent() << "case 0:\n";
+        ++indent;
+        ofile << indent() << "throw std::runtime_error(\"lexical error : state \" + std::to_string(state));\n\n";
         --indent;
+        for(std::size_t k = 0; k < accept_kind.size(); ++k){
+            ofile << indent() << "case " << k + 1 << ":\n";
+            ++indent;
+            if(accept_kind[k].second != "drop"){
+                ofile << indent() << "{\n";
+                ++indent;
+                generate_cpp_push_token(ofile, indent, accept_kind[k].first, accept_kind[k].second, sink, count);
+                --indent;
+                ofile << indent() << "}\n";
+            }
+            if(accept_kind[k].second == "drop" || sink != token_sink::stream){
+                ofile << indent() << "break;\n";
+            }
+            ofile << "\n";
+            --indent;
+        }
         ofile << indent() << "}\n";
+    }
+
+    // the line and char counting of a transition on c, for the table backend.
+    static void generate_cpp_table_advance(std::ostream &ofile, indent_type &indent, bool count){
+        if(count){
+            ofile << indent() << "if(c == " << static_cast<int>('\n') << "){\n";
+            ++indent;
+            ofile << indent() << "char_num = 0;\n";
+            ofile << indent() << "word_num = 0;\n";
+            ofile << indent() << "++line_num;\n";
+            --indent;
+            ofile << indent() << "}\n";
+            ofile << indent() << "++char_num;\n";
+        }
+        ofile << indent() << "++iter;\n";
+        ofile << indent() << "state = s;\n";
+        ofile << indent() << "continue;\n";
+    }
+
+    void lexer::generate_cpp_table(std::ostream &ofile, const std::string &lexer_namespace, position_policy positions){
+        indent_type indent;
+        bool count = positions == position_policy::eager;
+        std::string include_guard = generate_cpp_head(ofile, lexer_namespace, token_info_vector, indent, {}, false, positions);
+
+        // dense state ids, 0 is no state and 1 is the initial state.
+        std::vector<std::size_t> state_id(node_pool.size(), 0), id_to_state = { 0 };
+        for(std::size_t i = 1; i < node_pool.size(); ++i){
+            if(unused_node_set.find(i) == unused_node_set.end()){
+                state_id[i] = id_to_state.size();
+                id_to_state.push_back(i);
+            }
+        }
+        std::size_t state_count = id_to_state.size();
+
+        // accept kinds, 0 is not accepting. the initial state never accepts,
+        // as in the goto backend.
+        std::vector<std::pair<std::string, std::string>> accept_kind;
+        std::vector<std::size_t> accept(state_count, 0);
+        for(std::size_t id = 2; id < state_count; ++id){
+            const node &n = node_pool[id_to_state[id]];
+            if(!n.token_name){
+                continue;
+            }
+            auto kind = std::make_pair(*n.token_name, *n.action);
+            auto iter = std::find(accept_kind.begin(), accept_kind.end(), kind);
+            if(iter == accept_kind.end()){
+                accept_kind.push_back(kind);
+                accept[id] = accept_kind.size();
+            }else{
+                accept[id] = iter - accept_kind.begin() + 1;
+            }
+        }
+
+        // byte -> class + 1, bytes of no class go to the unused column 0.
+        std::size_t class_count = class_chars.size() + 1;
+        std::vector<std::size_t> class_map(256, 0);
+        for(std::size_t b = 0; b < 256; ++b){
+            if(char_class[b] != no_class){
+                class_map[b] = char_class[b] + 1;
+            }
+        }
+
+        // rows packed by row displacement, longest rows first. a cell
+        // belongs to state s when check holds s.
+        std::vector<std::vector<std::pair<std::size_t, std::size_t>>> row(state_count);
+        std::vector<std::size_t> order;
+        for(std::size_t id = 1; id < state_count; ++id){
+            for(auto &e : node_pool[id_to_state[id]].edge){
+                row[id].push_back(std::make_pair(class_map[static_cast<unsigned char>(e.first)], state_id[e.second]));
+            }
+            order.push_back(id);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y){ return row[x].size() > row[y].size(); });
+        std::vector<std::size_t> base(state_count, 0), next(class_count, 0), check(class_count, 0);
+        for(std::size_t id : order){
+            if(row[id].empty()){
+                continue;
+            }
+            std::size_t b = 0;
+            for(; ; ++b){
+                bool fit = true;
+                for(auto &cell : row[id]){
+                    if(b + cell.first < check.size() && check[b + cell.first] != 0){
+                        fit = false;
+                        break;
+                    }
+                }
+                if(fit){
+                    break;
+                }
+            }
+            base[id] = b;
+            if(check.size() < b + class_count){
+                next.resize(b + class_count, 0);
+                check.resize(b + class_count, 0);
+            }
+            for(auto &cell : row[id]){
+                next[b + cell.first] = cell.second;
+                check[b + cell.first] = id;
+            }
+        }
+
+        // transition and accept functions.
+        ofile << indent() << "// the state reached from state on c, 0 if there is none.\n";
+        ofile << indent() << "static std::size_t transition(std::size_t state, char c){\n";
+        ++indent;
+        generate_cpp_array(ofile, indent, "char_class", class_map);
+        generate_cpp_array(ofile, indent, "base", base);
+        generate_cpp_array(ofile, indent, "next", next);
+        generate_cpp_array(ofile, indent, "check", check);
+        ofile << indent() << "std::size_t i = base[state] + char_class[static_cast<unsigned char>(c)];\n";
+        ofile << indent() << "return check[i] == state ? next[i] : 0;\n";
+        --indent;
+        ofile << indent() << "}\n\n";
+        std::vector<bool> drop_only = drop_only_states();
+        std::vector<std::size_t> dropped(state_count, 0);
+        for(std::size_t id = 1; id < state_count; ++id){
+            dropped[id] = drop_only[id_to_state[id]] ? 1 : 0;
+        }
+        ofile << indent() << "// whether every token state can still end in is dropped.\n";
+        ofile << indent() << "static bool drop_only(std::size_t state){\n";
+        ++indent;
+        generate_cpp_array(ofile, indent, "drop_only", dropped);
+        ofile << indent() << "return drop_only[state] != 0;\n";
+        --indent;
+        ofile << indent() << "}\n\n";
+        ofile << indent() << "// the accept kind of state, 0 if it does not accept.\n";
+        ofile << indent() << "static std::size_t accept(std::size_t state){\n";
+        ++indent;
+        generate_cpp_array(ofile, indent, "accept", accept);
+        ofile << indent() << "return accept[state];\n";
+        --indent;
+        ofile << indent() << "}\n\n";
+
+        // next_token function.
+        generate_cpp_stream_head(ofile, indent);
+        ofile << indent() << "Iter first = iter;\n";
+        ofile << indent() << "std::size_t state = 1;\n";
+        ofile << indent() << "char c;\n\n";
+        ofile << indent() << "while(true){\n";
+        ++indent;
+        ofile << indent() << "if(iter != end){\n";
+        ++indent;
+        ofile << indent() << "c = *iter;\n";
+        ofile << indent() << "std::size_t s = transition(state, c);\n";
+        ofile << indent() << "if(s != 0){\n";
+        ++indent;
+        generate_cpp_table_advance(ofile, indent, count);
+        --indent;
+        ofile << indent() << "}\n";
+        --indent;
+        ofile << indent() << "}\n";
+        ofile << indent() << "if(state == 1){\n";
+        ++indent;
+        ofile << indent() << "if(iter == end){\n";
+        ++indent;
+        ofile << indent() << "break;\n";
+        --indent;
+        ofile << indent() << "}\n";
+        ofile << indent() << "throw std::runtime_error(\"lexical error : state 1\");\n";
+        --indent;
+        ofile << indent() << "}\n";
+        generate_cpp_accept_switch(ofile, indent, accept_kind, token_sink::stream, count);
+        ofile << indent() << "if(iter == end){\n";
+        ++indent;
+        ofile << indent() << "break;\n";
+        --indent;
+        ofile << indent() << "}\n";
+        ofile << indent() << "first = iter;\n";
+        ofile << indent() << "state = 1;\n";
+        --indent;
+        ofile << indent() << "}\n\n";
+        generate_cpp_end_token(ofile, indent, token_sink::stream);
+        generate_cpp_stream_tail(ofile, indent, count);
+
+        // feed and finish functions.
+        generate_cpp_push_head(ofile, indent);
+        ofile << indent() << "while(true){\n";
+        ++indent;
+        ofile << indent() << "if(iter == end){\n";
+        ++indent;
+        ofile << indent() << "if(drop_only(state)){\n";
+        ++indent;
+        ofile << indent() << "spill.clear();\n";
+        --indent;
+        ofile << indent() << "}else{\n";
+        ++indent;
+        ofile << indent() << "spill.append(first, iter);\n";
+        --indent;
+        ofile << indent() << "}\n";
+        ofile << indent() << "return;\n";
+        --indent;
+        ofile << indent() << "}\n";
+        ofile << indent() << "c = *iter;\n";
+        ofile << indent() << "std::size_t s = transition(state, c);\n";
+        ofile << indent() << "if(s != 0){\n";
+        ++indent;
+        generate_cpp_table_advance(ofile, indent, count);
+        --indent;
+        ofile << indent() << "}\n";
+        ofile << indent() << "if(state == 1){\n";
+        ++indent;
+        ofile << indent() << "throw std::runtime_error(\"lexical error : state 1\");\n";
+        --indent;
+        ofile << indent() << "}\n";
+        generate_cpp_accept_switch(ofile, indent, accept_kind, token_sink::push, count);
+        ofile << indent() << "spill.clear();\n";
+        ofile << indent() << "first = iter;\n";
+        ofile << indent() << "state = 1;\n";
+        --indent;
+        ofile << indent() << "}\n";
+        generate_cpp_push_middle(ofile, indent);
+        ofile << indent() << "if(state != 1){\n";
+        ++indent;
+        generate_cpp_accept_switch(ofile, indent, accept_kind, token_sink::finish, count);
+        --indent;
+        ofile << indent() << "}\n";
+        generate_cpp_push_tail(ofile, indent, count);
         --indent;
         ofile << indent() << "};\n";
 
@@ -1104,62 +2275,139 @@ namespace automaton{
     }
 
     void lexer::optimize(){
-        using edge = std::set<std::pair<char, std::size_t>>;
-        using node = std::set<edge>;
-
-        std::set<std::pair<std::size_t, std::size_t>> inequality_pair_set;
-        bool mod;
-        do{
-            mod = false;
-            for(std::size_t i = 0; i < node_pool.size(); ++i){
-                node node_i;
-                edge edge_i;
-                for(auto &a : node_pool[i].edge){
-                    edge_i.insert(a);
-                }
-                node_i.insert(std::move(edge_i));
-
-                for(std::size_t j = i + 1; j < node_pool.size(); ++j){
-                    if(
-                        node_pool[i].token_name && !node_pool[j].token_name ||
-                        !node_pool[i].token_name && node_pool[j].token_name ||
-                        node_pool[i].token_name != node_pool[j].token_name
-                        ){
-                        mod = inequality_pair_set.insert(std::make_pair(i, j)).second || mod;
-                    }else{
-                        node node_j;
-                        edge edge_j;
-                        for(auto &a : node_pool[j].edge){
-                            edge_j.insert(a);
-                        }
-                        node_j.insert(std::move(edge_j));
+        // Hopcroft's partition refinement. a missing edge goes to the dead
+        // state 0, which is kept in a block of its own. the other states start
+        // out grouped by (token name, action).
+        std::size_t n = node_pool.size();
+        std::vector<char> sigma;
+        for(char c : collect_char(node_pool)){
+            sigma.push_back(c);
+        }
+        std::size_t k = sigma.size();
+        std::vector<std::size_t> char_index(256, 0);
+        for(std::size_t a = 0; a < k; ++a){
+            char_index[static_cast<unsigned char>(sigma[a])] = a;
+        }
+        std::vector<std::vector<std::vector<std::size_t>>> inv(k, std::vector<std::vector<std::size_t>>(n));
+        for(std::size_t q = 0; q < n; ++q){
+            std::vector<std::size_t> target(k, 0);
+            for(auto &e : node_pool[q].edge){
+                target[char_index[static_cast<unsigned char>(e.first)]] = e.second;
+            }
+            for(std::size_t a = 0; a < k; ++a){
+                inv[a][target[a]].push_back(q);
+            }
+        }
 
-                        if(node_i != node_j){
-                            mod = inequality_pair_set.insert(std::make_pair(i, j)).second || mod;
-                        }
-                    }
+        // blocks are ranges [first, last) of elems, the first marked[b]
+        // elements of block b are the ones marked by the current splitter.
+        std::vector<std::size_t> elems(n), loc(n), block_of(n), first, last, marked;
+        {
+            std::map<std::tuple<int, std::string, std::string>, std::size_t> initial;
+            for(std::size_t q = 0; q < n; ++q){
+                std::tuple<int, std::string, std::string> key(q == 0 ? 0 : 1, "", "");
+                if(q > 0 && node_pool[q].token_name){
+                    key = std::make_tuple(2, *node_pool[q].token_name, *node_pool[q].action);
                 }
+                block_of[q] = initial.insert(std::make_pair(key, initial.size())).first->second;
+            }
+            std::vector<std::size_t> size(initial.size(), 0);
+            for(std::size_t q = 0; q < n; ++q){
+                ++size[block_of[q]];
+            }
+            std::size_t f = 0;
+            for(std::size_t b = 0; b < initial.size(); ++b){
+                first.push_back(f);
+                last.push_back(f);
+                marked.push_back(0);
+                f += size[b];
             }
-        }while(mod);
+            for(std::size_t q = 0; q < n; ++q){
+                std::size_t &i = last[block_of[q]];
+                elems[i] = q;
+                loc[q] = i;
+                ++i;
+            }
+        }
 
-        std::map<std::size_t, std::size_t> equality_pair_map;
-        for(std::size_t i = 0; i < node_pool.size(); ++i){
-            for(std::size_t j = i + 1; j < node_pool.size(); ++j){
-                if(inequality_pair_set.find(std::make_pair(i, j)) != inequality_pair_set.end()){
+        std::vector<std::pair<std::size_t, std::size_t>> worklist;
+        std::vector<bool> in_worklist(first.size() * k, false);
+        for(std::size_t b = 0; b < first.size(); ++b){
+            for(std::size_t a = 0; a < k; ++a){
+                worklist.push_back(std::make_pair(b, a));
+                in_worklist[b * k + a] = true;
+            }
+        }
+
+        std::vector<std::size_t> pre, touched;
+        while(!worklist.empty()){
+            std::size_t b = worklist.back().first, a = worklist.back().second;
+            worklist.pop_back();
+            in_worklist[b * k + a] = false;
+            pre.clear();
+            for(std::size_t i = first[b]; i < last[b]; ++i){
+                for(std::size_t p : inv[a][elems[i]]){
+                    pre.push_back(p);
+                }
+            }
+            touched.clear();
+            for(std::size_t p : pre){
+                std::size_t c = block_of[p], m = first[c] + marked[c];
+                if(loc[p] < m){
                     continue;
-                }else{
-                    equality_pair_map.insert(std::make_pair(j, i));
+                }
+                if(marked[c] == 0){
+                    touched.push_back(c);
+                }
+                std::size_t q = elems[m];
+                elems[m] = p;
+                elems[loc[p]] = q;
+                loc[q] = loc[p];
+                loc[p] = m;
+                ++marked[c];
+            }
+            for(std::size_t c : touched){
+                std::size_t m = marked[c];
+                marked[c] = 0;
+                if(m == last[c] - first[c]){
+                    continue;
+                }
+                std::size_t d = first.size();
+                first.push_back(first[c]);
+                last.push_back(first[c] + m);
+                marked.push_back(0);
+                first[c] += m;
+                for(std::size_t i = first[d]; i < last[d]; ++i){
+                    block_of[elems[i]] = d;
+                }
+                in_worklist.resize(first.size() * k, false);
+                for(std::size_t x = 0; x < k; ++x){
+                    std::size_t y = d;
+                    if(!in_worklist[c * k + x] && last[c] - first[c] < last[d] - first[d]){
+                        y = c;
+                    }
+                    if(!in_worklist[y * k + x]){
+                        worklist.push_back(std::make_pair(y, x));
+                        in_worklist[y * k + x] = true;
+                    }
                 }
             }
         }
 
-        for(auto &a : node_pool){
-            for(auto &e : a.edge){
-                auto iter = equality_pair_map.find(e.second);
-                if(iter != equality_pair_map.end()){
-                    e.second = equality_pair_map[e.second];
-                    unused_node_set.insert(e.second);
-                }
+        // the smallest state of each block stands for it, so state 1 stays
+        // the initial state.
+        std::vector<std::size_t> representative(first.size(), n);
+        for(std::size_t q = 0; q < n; ++q){
+            std::size_t &r = representative[block_of[q]];
+            if(r == n){
+                r = q;
+            }else{
+                unused_node_set.insert(q);
+            }
+        }
+        for(std::size_t q = 0; q < n; ++q){
+            for(auto &e : node_pool[q].edge){
+                e.second = representative[block_of[e.second]];
             }
         }
     }
@@ -15,10 +15,14 @@
 #include <stack>
 #include <set>
 #include <map>
+#include <unordered_map>
+#include <tuple>
 #include <cctype>
 #include <cstdio>
 #include "regexp_parser.hpp"
 
+struct indent_type;
+
 namespace automaton{
     class node{
     public:
@@ -64,14 +68,30 @@ namespace automaton{
         using token_name_vector_type = std::vector<token_info>;
         token_name_vector_type token_info_vector;
 
+        // how the generated lexer keeps line, char and word numbers.
+        enum class position_policy{
+            eager,
+            none,
+            lazy
+        };
+
         lexer() = default;
         virtual ~lexer() = default;
         void add_rule(const std::string &str, const std::string &token_name, const std::string &action);
         void build();
-        void generate_cpp(std::ostream &ofile_path, const std::string &lexer_namespace);
+        void generate_cpp(std::ostream &ofile_path, const std::string &lexer_namespace, position_policy positions = position_policy::eager);
+        void generate_cpp_table(std::ostream &ofile_path, const std::string &lexer_namespace, position_policy positions = position_policy::eager);
+
+        // byte classes, char_class is indexed by unsigned char.
+        static constexpr std::size_t no_class = static_cast<std::size_t>(-1);
+        std::vector<std::size_t> char_class;
+        std::vector<std::vector<char>> class_chars;
 
     private:
+        void make_char_class();
         void optimize();
+        std::vector<bool> drop_only_states() const;
+        void generate_cpp_goto_states(std::ostream &ofile, indent_type &indent, bool push, bool count);
 
         node_pool node_pool;
         std::set<std::size_t> unused_node_set;
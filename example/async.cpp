@@ -0,0 +1,111 @@
+// parse_async on many interleaved tasks, each with its own parser, against
+// parse() on the whole input. every source hands out its text in chunks of
+// 1 to 7 bytes and suspends before each one, and a simple queue resumes
+// the suspended tasks in turn.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <random>
+#include <coroutine>
+#include "lxq.hpp"
+#include "mylexer.hpp"
+#include "myparser.hpp"
+#include "calc_proc.hpp"
+#include "random_lines.hpp"
+
+struct lexer : mylexer<const char*>{
+    using iterator = const char*;
+};
+
+using parser_type = myparser::parser<lexer, example::proc>;
+
+std::deque<std::coroutine_handle<>> ready;
+
+struct source{
+    std::string text;
+    std::size_t pos;
+    std::mt19937 random;
+
+    struct awaiter{
+        source &s;
+
+        bool await_ready(){
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h){
+            ready.push_back(h);
+        }
+
+        std::pair<const char*, const char*> await_resume(){
+            std::size_t n = std::min<std::size_t>(s.text.size() - s.pos, 1 + s.random() % 7);
+            const char *p = s.text.data() + s.pos;
+            s.pos += n;
+            return std::make_pair(p, p + n);
+        }
+    };
+
+    awaiter next(){
+        return awaiter{ *this };
+    }
+};
+
+lxq::task<std::string> session(source &src, example::proc &p){
+    parser_type parser(p);
+    bool accepted = co_await parser.parse_async(src, p);
+    co_return (accepted ? "accept " : "reject ") + p.out;
+}
+
+static std::string parse_whole(const std::string &text){
+    example::proc p;
+    try{
+        auto tokens = lexer::tokenize(text.data(), text.data() + text.size(), p);
+        parser_type parser(p);
+        lxq::value_ptr v;
+        parser.parse(v, tokens.begin(), tokens.end());
+    }catch(parser_type::parsing_error const&){
+        return "error";
+    }
+    return "accept " + p.out;
+}
+
+int main(){
+    const std::size_t count = 1000;
+    std::mt19937 random(22);
+    std::vector<std::unique_ptr<source>> sources;
+    std::vector<std::unique_ptr<example::proc>> procs;
+    std::vector<lxq::task<std::string>> tasks;
+    for(std::size_t i = 0; i < count; ++i){
+        sources.emplace_back(new source{ example::lines(random), 0, std::mt19937(static_cast<unsigned int>(i)) });
+        procs.emplace_back(new example::proc);
+        tasks.push_back(session(*sources[i], *procs[i]));
+    }
+    for(auto &t : tasks){
+        t.start();
+    }
+    while(!ready.empty()){
+        std::coroutine_handle<> h = ready.front();
+        ready.pop_front();
+        h.resume();
+    }
+    for(std::size_t i = 0; i < count; ++i){
+        if(!tasks[i].done()){
+            std::cerr << "task " << i << " did not finish.\n";
+            return 1;
+        }
+        std::string result;
+        try{
+            result = tasks[i].result();
+        }catch(parser_type::parsing_error const&){
+            result = "error";
+        }
+        if(result != parse_whole(sources[i]->text)){
+            std::cerr << "parse_async and parse() differ on '" << sources[i]->text << "'.\n";
+            return 1;
+        }
+    }
+    std::cout << count << " tasks\n";
+    return 0;
+}
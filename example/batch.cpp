@@ -0,0 +1,114 @@
+// parse_batch under the arena policy against parsing the same inputs one
+// by one, then a result type with no default constructor, and a result
+// that would keep a value of the arena alive.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <cstdlib>
+#include "lxq.hpp"
+#include "mylexer.hpp"
+#include "myparser.hpp"
+#include "calc_proc.hpp"
+#include "random_lines.hpp"
+
+// the actions of calc_proc.hpp with their values in the arena.
+struct arena_proc{
+    lxq::arena *arena;
+    std::string out;
+
+    template<class Iter>
+    lxq::semantic_data *make_id(lxq::arena &a, Iter first, Iter last){
+        return new(a) example::num(std::atol(std::string(first, last).c_str()) % 1000);
+    }
+
+    lxq::semantic_data *print(lxq::arena&, lxq::semantic_data *a){
+        out += std::to_string(example::value_of(a)) + " ";
+        return nullptr;
+    }
+
+    lxq::semantic_data *recover(lxq::arena&){
+        out += "recover ";
+        return nullptr;
+    }
+
+    lxq::semantic_data *make_add(lxq::arena &m, lxq::semantic_data *a, lxq::semantic_data *b){ return new(m) example::num((example::value_of(a) + example::value_of(b)) % 1000003); }
+    lxq::semantic_data *make_sub(lxq::arena &m, lxq::semantic_data *a, lxq::semantic_data *b){ return new(m) example::num((example::value_of(a) - example::value_of(b)) % 1000003); }
+    lxq::semantic_data *make_mlt(lxq::arena &m, lxq::semantic_data *a, lxq::semantic_data *b){ return new(m) example::num((example::value_of(a) * example::value_of(b)) % 1000003); }
+    lxq::semantic_data *make_div(lxq::arena &m, lxq::semantic_data *a, lxq::semantic_data *b){ return new(m) example::num(example::value_of(b) != 0 ? example::value_of(a) / example::value_of(b) : 0); }
+    lxq::semantic_data *make_inv(lxq::arena &m, lxq::semantic_data *a){ return new(m) example::num(-example::value_of(a)); }
+    lxq::semantic_data *identity(lxq::arena &m, lxq::semantic_data *a){ return new(m) example::num(example::value_of(a)); }
+};
+
+struct lexer : mylexer<const char*>{
+    using iterator = const char*;
+};
+
+using parser_type = myparser::parser<lexer, arena_proc, 0, lxq::arena>;
+
+static std::string parse_one(parser_type &p, const std::string &src){
+    arena_proc &proc = p.semantic_data_proc;
+    proc.out.clear();
+    try{
+        auto tokens = lexer::tokenize(src.data(), src.data() + src.size(), proc, *proc.arena);
+        lxq::value_ptr v;
+        p.parse(v, tokens.begin(), tokens.end());
+    }catch(parser_type::parsing_error const&){
+        return "error";
+    }
+    return proc.out;
+}
+
+struct line_count{
+    std::size_t n;
+
+    explicit line_count(std::size_t n) : n(n){}
+};
+
+int main(){
+    std::mt19937 random(23);
+    std::vector<std::string> inputs;
+    for(int i = 0; i < 5000; ++i){
+        inputs.push_back(example::lines(random));
+    }
+    auto make_proc = [](lxq::arena &a){ return arena_proc{ &a, "" }; };
+
+    std::vector<std::string> sequential;
+    {
+        lxq::arena arena;
+        arena_proc proc = make_proc(arena);
+        parser_type p(proc, arena);
+        for(const std::string &src : inputs){
+            sequential.push_back(parse_one(p, src));
+            p.reset();
+        }
+    }
+    for(std::size_t jobs : { 1, 4, 16 }){
+        if(parser_type::parse_batch(inputs.begin(), inputs.end(), jobs, make_proc, parse_one) != sequential){
+            std::cerr << "parse_batch on " << jobs << " threads differs from sequential parsing.\n";
+            return 1;
+        }
+    }
+
+    auto counts = parser_type::parse_batch(inputs.begin(), inputs.begin() + 100, 4, make_proc, [](parser_type&, const std::string &src){
+        return line_count(static_cast<std::size_t>(std::count(src.begin(), src.end(), ';')));
+    });
+    if(counts.size() != 100 || counts[0].n != static_cast<std::size_t>(std::count(inputs[0].begin(), inputs[0].end(), ';'))){
+        std::cerr << "results without a default constructor are wrong.\n";
+        return 1;
+    }
+
+    try{
+        parser_type::parse_batch(inputs.begin(), inputs.begin() + 100, 4, make_proc, [](parser_type &p, const std::string&){
+            lxq::arena &arena = *p.semantic_data_proc.arena;
+            return lxq::own(&arena, new(arena) example::num(1));
+        });
+        std::cerr << "a result holding a value of the arena was accepted.\n";
+        return 1;
+    }catch(std::runtime_error const&){}
+
+    std::cout << sequential.size() << " inputs\n";
+    return 0;
+}
@@ -0,0 +1,59 @@
+// test.lxq on fixed inputs with known results, then on random lines. the
+// transcript is printed so that the outputs of the parser backends can be
+// compared.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include "lxq.hpp"
+#include "mylexer.hpp"
+#include "myparser.hpp"
+#include "calc_proc.hpp"
+#include "random_lines.hpp"
+
+struct lexer : mylexer<std::string::const_iterator>{
+    using iterator = std::string::const_iterator;
+};
+
+using parser_type = myparser::parser<lexer, example::proc>;
+
+static std::string run(const std::string &src){
+    example::proc p;
+    try{
+        auto tokens = lexer::tokenize(src.cbegin(), src.cend(), p);
+        parser_type parser(p);
+        lxq::value_ptr v;
+        parser.parse(v, tokens.begin(), tokens.end());
+    }catch(parser_type::parsing_error const&){
+        p.out += "error";
+    }
+    return p.out;
+}
+
+int main(){
+    struct{
+        const char *src, *expected;
+    } fixed[] = {
+        { "1+2*3;", "7 " },
+        { "(1+2)*3;  -4-5; ; 10/2-3;", "9 -9 2 " },
+        { "1 2 recover; 4;", "recover 4 " },
+        { "--3; 2*-3;", "3 -6 " },
+        { "", "" },
+        { "1+;", "error" },
+        { "(1;", "error" }
+    };
+    for(auto &f : fixed){
+        std::string out = run(f.src);
+        if(out != f.expected){
+            std::cerr << "'" << f.src << "' gives '" << out << "', not '" << f.expected << "'.\n";
+            return 1;
+        }
+    }
+
+    std::mt19937 random(20);
+    for(int i = 0; i < 2000; ++i){
+        std::cout << run(example::lines(random)) << "\n";
+    }
+    return 0;
+}
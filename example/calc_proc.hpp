@@ -0,0 +1,47 @@
+#ifndef EXAMPLE_CALC_PROC_HPP_
+#define EXAMPLE_CALC_PROC_HPP_
+
+#include <string>
+#include <cstdlib>
+#include "lxq.hpp"
+
+// semantic actions of test.lxq. the values are kept small so that random
+// input does not overflow.
+namespace example{
+    struct num : lxq::semantic_data{
+        long v;
+        num(long v) : v(v){}
+    };
+
+    inline long value_of(lxq::semantic_data *p){
+        return p ? static_cast<num*>(p)->v : 0;
+    }
+
+    struct proc{
+        std::string out;
+
+        template<class Iter>
+        lxq::semantic_data *make_id(Iter first, Iter last){
+            return new num(std::atol(std::string(first, last).c_str()) % 1000);
+        }
+
+        lxq::semantic_data *print(lxq::semantic_data *a){
+            out += std::to_string(value_of(a)) + " ";
+            return nullptr;
+        }
+
+        lxq::semantic_data *recover(){
+            out += "recover ";
+            return nullptr;
+        }
+
+        lxq::semantic_data *make_add(lxq::semantic_data *a, lxq::semantic_data *b){ return new num((value_of(a) + value_of(b)) % 1000003); }
+        lxq::semantic_data *make_sub(lxq::semantic_data *a, lxq::semantic_data *b){ return new num((value_of(a) - value_of(b)) % 1000003); }
+        lxq::semantic_data *make_mlt(lxq::semantic_data *a, lxq::semantic_data *b){ return new num((value_of(a) * value_of(b)) % 1000003); }
+        lxq::semantic_data *make_div(lxq::semantic_data *a, lxq::semantic_data *b){ return new num(value_of(b) != 0 ? value_of(a) / value_of(b) : 0); }
+        lxq::semantic_data *make_inv(lxq::semantic_data *a){ return new num(-value_of(a)); }
+        lxq::semantic_data *identity(lxq::semantic_data *a){ return new num(value_of(a)); }
+    };
+}
+
+#endif // EXAMPLE_CALC_PROC_HPP_
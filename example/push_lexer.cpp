@@ -0,0 +1,86 @@
+// push lexer of test.lxq fed in small chunks against tokenize() on the
+// whole input, and a long dropped run that must not be held in the spill
+// buffer.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include "lxq.hpp"
+#include "mylexer.hpp"
+
+struct num : lxq::semantic_data{
+    long v;
+    num(long v) : v(v){}
+};
+
+struct proc{
+    template<class Iter>
+    lxq::semantic_data *make_id(Iter first, Iter last){
+        return new num(std::atol(std::string(first, last).c_str()));
+    }
+};
+
+using lexer = mylexer<const char*>;
+
+struct token_record{
+    int identifier;
+    std::string text;
+    std::size_t line_num, char_num, word_num;
+    long value;
+
+    bool operator ==(const token_record &other) const{
+        return identifier == other.identifier && text == other.text && line_num == other.line_num && char_num == other.char_num && word_num == other.word_num && value == other.value;
+    }
+};
+
+static token_record record(const lexer::token_type &t){
+    long value = t.value ? static_cast<num*>(t.value.get())->v : -1;
+    return token_record{ static_cast<int>(t.identifier), std::string(t.first, t.last), t.line_num, t.char_num, t.word_num, value };
+}
+
+int main(){
+    std::string src = "12+345*(6 - 78);   recover ; -9/10;;  1234567 recover;  (((1)));";
+    proc p;
+    std::vector<token_record> whole;
+    for(auto &t : lexer::tokenize(src.data(), src.data() + src.size(), p)){
+        whole.push_back(record(t));
+    }
+
+    for(std::size_t chunk = 1; chunk <= 8; ++chunk){
+        std::vector<token_record> pushed;
+        auto sink = [&](lexer::token_type &&t){ pushed.push_back(record(t)); };
+        lexer::push_stream<proc> s(p);
+        for(std::size_t i = 0; i < src.size(); i += chunk){
+            std::size_t n = std::min(chunk, src.size() - i);
+            s.feed(src.data() + i, src.data() + i + n, sink);
+        }
+        s.finish(sink);
+        if(!(pushed == whole)){
+            std::cerr << "chunk size " << chunk << ": push lexer differs from tokenize.\n";
+            return 1;
+        }
+    }
+
+    // 16 MiB of spaces in 4 KiB chunks between two tokens.
+    std::vector<token_record> pushed;
+    auto sink = [&](lexer::token_type &&t){ pushed.push_back(record(t)); };
+    lexer::push_stream<proc> s(p);
+    std::string spaces(4096, ' ');
+    s.feed("1", "1" + 1, sink);
+    for(std::size_t i = 0; i < 4096; ++i){
+        s.feed(spaces.data(), spaces.data() + spaces.size(), sink);
+        if(s.spilled() != 0){
+            std::cerr << "a dropped run is held in the spill buffer, " << s.spilled() << " bytes.\n";
+            return 1;
+        }
+    }
+    std::string tail = "2;";
+    s.feed(tail.data(), tail.data() + tail.size(), sink);
+    s.finish(sink);
+    if(pushed.size() != 4 || pushed[0].value != 1 || pushed[1].value != 2 || pushed[1].char_num != 4096 * 4096 + 2){
+        std::cerr << "tokens around a long dropped run are wrong.\n";
+        return 1;
+    }
+    std::cout << whole.size() << " tokens\n";
+    return 0;
+}
@@ -0,0 +1,59 @@
+// post() fed one token at a time against parse() on the same tokens of
+// random test.lxq input. one parser object of each kind is reused for all
+// inputs.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include "lxq.hpp"
+#include "mylexer.hpp"
+#include "myparser.hpp"
+#include "calc_proc.hpp"
+#include "random_lines.hpp"
+
+struct lexer : mylexer<std::string::const_iterator>{
+    using iterator = std::string::const_iterator;
+};
+
+using parser_type = myparser::parser<lexer, example::proc>;
+
+int main(){
+    example::proc parse_proc, post_proc;
+    parser_type parse_parser(parse_proc), post_parser(post_proc);
+    std::mt19937 random(21);
+    std::size_t accepted_count = 0;
+    for(int i = 0; i < 2000; ++i){
+        std::string src = example::lines(random);
+
+        parse_proc.out.clear();
+        bool parse_accepted = true;
+        try{
+            auto tokens = lexer::tokenize(src.cbegin(), src.cend(), parse_proc);
+            lxq::value_ptr v;
+            parse_parser.parse(v, tokens.begin(), tokens.end());
+        }catch(parser_type::parsing_error const&){
+            parse_accepted = false;
+        }
+
+        post_proc.out.clear();
+        bool post_accepted = false;
+        try{
+            auto tokens = lexer::tokenize(src.cbegin(), src.cend(), post_proc);
+            post_parser.reset();
+            for(auto &t : tokens){
+                if(post_parser.post(t)){
+                    post_accepted = true;
+                    break;
+                }
+            }
+        }catch(parser_type::parsing_error const&){}
+
+        if(parse_accepted != post_accepted || parse_proc.out != post_proc.out){
+            std::cerr << "post() and parse() differ on '" << src << "'.\n";
+            return 1;
+        }
+        accepted_count += parse_accepted ? 1 : 0;
+    }
+    std::cout << accepted_count << " of 2000 accepted\n";
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef EXAMPLE_RANDOM_LINES_HPP_
+#define EXAMPLE_RANDOM_LINES_HPP_
+
+#include <string>
+#include <random>
+
+// random input for test.lxq.
+namespace example{
+    inline std::string expression(std::mt19937 &random, int depth){
+        switch(depth > 0 ? random() % 5 : 0){
+        case 0:
+            return std::to_string(random() % 100);
+
+        case 1:
+            return "(" + expression(random, depth - 1) + ")";
+
+        case 2:
+            return "-" + expression(random, depth - 1);
+
+        default:
+            {
+                std::string lhs = expression(random, depth - 1);
+                char op = "+-*/"[random() % 4];
+                return lhs + op + expression(random, depth - 1);
+            }
+        }
+    }
+
+    // one to four lines, some with a stray piece and a recover.
+    inline std::string lines(std::mt19937 &random){
+        static const char *pieces[] = { "1", "+", "-", "*", "/", "(", ")", ";", "recover" };
+        std::string src;
+        for(std::size_t n = 1 + random() % 4; n > 0; --n){
+            std::string line = expression(random, 4);
+            if(random() % 6 == 0){
+                line.insert(random() % (line.size() + 1), pieces[random() % (sizeof(pieces) / sizeof(pieces[0]))]);
+                line += " recover";
+            }
+            src += line + "; ";
+        }
+        return src;
+    }
+}
+
+#endif // EXAMPLE_RANDOM_LINES_HPP_
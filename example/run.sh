@@ -0,0 +1,69 @@
+#!/bin/sh
+# generates the example grammars, then builds and runs each driver. every
+# driver checks its own results and exits non-zero on a mismatch.
+# usage: example/run.sh path/to/lxq
+set -e
+lxq=$1
+dir=$(cd "$(dirname "$0")" && pwd)
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+CXX=${CXX:-g++}
+
+# run <name> <grammar> <driver> <standard> [lxq options...]
+run(){
+    name=$1
+    grammar=$2
+    driver=$3
+    standard=$4
+    shift 4
+    mkdir -p "$out/$name"
+    "$lxq" "$@" "$dir/../$grammar" "$out/$name" > /dev/null
+    $CXX -std=$standard -pthread -I "$out/$name" -o "$out/$name/driver" "$dir/$driver"
+    "$out/$name/driver" > "$out/$name/output"
+    echo "$name ok"
+}
+
+for backend in goto table; do
+    run push_lexer_$backend test.lxq push_lexer.cpp c++14 --lexer-backend=$backend
+done
+for backend in table goto; do
+    run calc_$backend test.lxq calc.cpp c++14 --parser-backend=$backend
+done
+cmp "$out/calc_table/output" "$out/calc_goto/output"
+echo "calc backends agree"
+
+for backend in table goto; do
+    run typed_$backend test_typed.lxq typed.cpp c++14 --parser-backend=$backend
+done
+
+for backend in table goto; do
+    run push_parser_$backend test.lxq push_parser.cpp c++14 --parser-backend=$backend
+done
+
+for backend in table goto; do
+    run async_$backend test.lxq async.cpp c++20 --parser-backend=$backend
+done
+
+for backend in table goto; do
+    run batch_$backend test.lxq batch.cpp c++14 --parser-backend=$backend
+done
+
+for backend in table goto; do
+    run validate_$backend test.lxq validate.cpp c++14 --parser-backend=$backend
+done
+
+# every lalr builder must generate the same parser for each example grammar
+build(){
+    mkdir -p "$out/$1"
+    "$lxq" "$3" "$dir/../$2" "$out/$1" > /dev/null
+}
+for grammar in test test_typed; do
+    build ${grammar}_set $grammar.lxq --lalr-builder=set
+    build ${grammar}_dense $grammar.lxq --lalr-builder=dense
+    build ${grammar}_deremer_pennello $grammar.lxq --lalr-lookahead=deremer-pennello
+    build ${grammar}_jobs $grammar.lxq --jobs=4
+    for builder in dense deremer_pennello jobs; do
+        diff -r "$out/${grammar}_set" "$out/${grammar}_$builder"
+    done
+    echo "$grammar builders agree"
+done
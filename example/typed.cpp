@@ -0,0 +1,67 @@
+// test_typed.lxq, whose tokens and rules carry C++ value types. two typed
+// tokens are declared on one line of the grammar.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdlib>
+#include "lxq.hpp"
+#include "typedlexer.hpp"
+#include "typedparser.hpp"
+
+struct proc{
+    std::map<std::string, long> vars;
+
+    template<class Iter>
+    long make_id(Iter first, Iter last){
+        return std::atol(std::string(first, last).c_str());
+    }
+
+    template<class Iter>
+    std::string make_name(Iter first, Iter last){
+        return std::string(first, last);
+    }
+
+    std::vector<long> push(std::vector<long> lines, long a){
+        lines.push_back(a);
+        return lines;
+    }
+
+    std::vector<long> assign(std::vector<long> lines, std::string name, long a){
+        vars[name] = a;
+        return lines;
+    }
+
+    long lookup(std::string name){
+        return vars.at(name);
+    }
+
+    long make_add(long a, long b){ return a + b; }
+    long make_sub(long a, long b){ return a - b; }
+    long make_mlt(long a, long b){ return a * b; }
+    long make_div(long a, long b){ return a / b; }
+    long make_inv(long a){ return -a; }
+    long identity(long a){ return a; }
+};
+
+struct lexer : typedlexer<std::string::const_iterator>{
+    using iterator = std::string::const_iterator;
+};
+
+int main(){
+    std::string src = "x = 1+2*3; y = x*2; x; y - x; -x; (x + y) / 3; width = 40; width*y;";
+    std::vector<long> expected = { 7, 7, -7, 7, 560 };
+    proc p;
+    auto tokens = lexer::tokenize(src.cbegin(), src.cend(), p);
+    typedparser::parser<lexer, proc> parser(p);
+    std::vector<long> lines;
+    parser.parse(lines, tokens.begin(), tokens.end());
+    if(lines != expected){
+        std::cerr << "typed values differ.\n";
+        return 1;
+    }
+    for(long a : lines){
+        std::cout << a << "\n";
+    }
+    return 0;
+}
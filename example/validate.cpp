@@ -0,0 +1,48 @@
+// validate() against parse() on random test.lxq input. validate() has no
+// error recovery, so it must accept exactly the inputs that parse()
+// accepts without running the recover action.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include "lxq.hpp"
+#include "mylexer.hpp"
+#include "myparser.hpp"
+#include "calc_proc.hpp"
+#include "random_lines.hpp"
+
+struct lexer : mylexer<std::string::const_iterator>{
+    using iterator = std::string::const_iterator;
+};
+
+using parser_type = myparser::parser<lexer, example::proc>;
+
+int main(){
+    example::proc p;
+    parser_type parser(p);
+    std::mt19937 random(25);
+    std::size_t valid_count = 0;
+    for(int i = 0; i < 4000; ++i){
+        std::string src = example::lines(random);
+        auto tokens = lexer::tokenize(src.cbegin(), src.cend(), p);
+        bool valid = parser.validate(tokens.begin(), tokens.end()) == tokens.end();
+
+        p.out.clear();
+        bool clean = true;
+        try{
+            lxq::value_ptr v;
+            parser.parse(v, tokens.begin(), tokens.end());
+            clean = p.out.find("recover") == std::string::npos;
+        }catch(parser_type::parsing_error const&){
+            clean = false;
+        }
+
+        if(valid != clean){
+            std::cerr << "validate() " << (valid ? "accepts" : "rejects") << " '" << src << "', parse() does not agree.\n";
+            return 1;
+        }
+        valid_count += valid ? 1 : 0;
+    }
+    std::cout << valid_count << " of 4000 valid\n";
+    return 0;
+}
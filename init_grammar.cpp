@@ -55,9 +55,14 @@ namespace scanner{
             seq({ l_square_bracket, identifier, r_square_bracket }, eat)
         });
 
+        decl_g("ValueType_opt") = scanner::rule_rhs({
+            seq({}, eat),
+            seq({ l_bracket, string, r_bracket }, eat)
+        });
+
         decl_g("IdentifierSeq") = scanner::rule_rhs({
-            seq({ identifier }, eat),
-            seq({ nt("IdentifierSeq"), comma, identifier }, eat)
+            seq({ identifier, nt("ValueType_opt") }, eat),
+            seq({ nt("IdentifierSeq"), comma, identifier, nt("ValueType_opt") }, eat)
         });
 
         decl_g("LinkDir") = scanner::rule_rhs({
@@ -133,7 +138,7 @@ namespace scanner{
         });
 
         decl_g("LHS") = scanner::rule_rhs({
-            seq({ identifier }, eat)
+            seq({ identifier, nt("ValueType_opt") }, eat)
         });
 
         decl_g("Expr") = scanner::rule_rhs({
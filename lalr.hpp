@@ -15,8 +15,111 @@
 #include <stack>
 #include <set>
 #include <map>
+#include <unordered_map>
+#include <limits>
+#include <thread>
+#include <atomic>
 #include <cctype>
 #include <cstdio>
+#include <cstdint>
+
+class dynamic_bitset{
+public:
+    using word_type = std::uint64_t;
+    static std::size_t const word_bits = 64;
+
+    dynamic_bitset() = default;
+    explicit dynamic_bitset(std::size_t n) : words((n + word_bits - 1) / word_bits, 0){}
+
+    void resize(std::size_t n){
+        words.resize((n + word_bits - 1) / word_bits, 0);
+    }
+
+    bool test(std::size_t i) const{
+        return (words[i / word_bits] >> (i % word_bits)) & 1;
+    }
+
+    bool set(std::size_t i){
+        word_type &w = words[i / word_bits], m = word_type(1) << (i % word_bits);
+        bool r = (w & m) == 0;
+        w |= m;
+        return r;
+    }
+
+    void clear(){
+        std::fill(words.begin(), words.end(), 0);
+    }
+
+    bool none() const{
+        for(word_type w : words){
+            if(w != 0){ return false; }
+        }
+        return true;
+    }
+
+    // this |= other, returns true if this has been changed.
+    bool merge(dynamic_bitset const &other){
+        word_type changed = 0;
+        for(std::size_t i = 0; i < words.size(); ++i){
+            word_type w = words[i] | other.words[i];
+            changed |= w ^ words[i];
+            words[i] = w;
+        }
+        return changed != 0;
+    }
+
+    template<class F>
+    void for_each(F f) const{
+        for(std::size_t i = 0; i < words.size(); ++i){
+            for(word_type w = words[i]; w != 0; w &= w - 1){
+                f(i * word_bits + count_trailing_zero(w));
+            }
+        }
+    }
+
+    bool operator ==(dynamic_bitset const &other) const{
+        return words == other.words;
+    }
+
+    bool operator !=(dynamic_bitset const &other) const{
+        return words != other.words;
+    }
+
+    // same ordering as std::set<std::size_t>::operator < on the set bits.
+    int compare(dynamic_bitset const &other) const{
+        for(std::size_t i = 0; i < words.size(); ++i){
+            word_type d = words[i] ^ other.words[i];
+            if(d == 0){ continue; }
+            std::size_t k = count_trailing_zero(d);
+            bool mine = (words[i] >> k) & 1;
+            dynamic_bitset const &rest = mine ? other : *this;
+            bool rest_has_more = k + 1 < word_bits && (rest.words[i] >> (k + 1)) != 0;
+            for(std::size_t j = i + 1; !rest_has_more && j < words.size(); ++j){
+                rest_has_more = rest.words[j] != 0;
+            }
+            return mine == rest_has_more ? -1 : 1;
+        }
+        return 0;
+    }
+
+    std::size_t hash() const{
+        std::size_t h = 0;
+        for(word_type w : words){
+            h = h * 1000003 ^ static_cast<std::size_t>(w ^ (w >> 32));
+        }
+        return h;
+    }
+
+private:
+    static std::size_t count_trailing_zero(word_type w){
+        std::size_t n = 0;
+        for(; (w & 0xffff) == 0; w >>= 16){ n += 16; }
+        for(; (w & 1) == 0; w >>= 1){ ++n; }
+        return n;
+    }
+
+    std::vector<word_type> words;
+};
 
 template<class Term>
 struct default_epsilon_functor{
@@ -159,7 +262,7 @@ public:
 
         items() : base_type(), mirror(nullptr), goto_map(){}
         items(items const &other) : base_type(other), mirror(other.mirror), goto_map(other.goto_map){}
-        items(items &&other) : base_type(other), mirror(std::move(other.mirror)), goto_map(std::move(other.goto_map)){}
+        items(items &&other) : base_type(std::move(other)), mirror(std::move(other.mirror)), goto_map(std::move(other.goto_map)){}
         items(std::initializer_list<item> list) : base_type(list), mirror(nullptr), goto_map(){}
 
         items &operator =(items const &other){
@@ -170,7 +273,7 @@ public:
         }
 
         items &operator =(items &&other){
-            base_type::operator =(other);
+            base_type::operator =(std::move(other));
             mirror = std::move(other.mirror);
             goto_map.operator =(std::move(other.goto_map));
             return *this;
@@ -346,110 +449,239 @@ public:
         return s;
     }
 
-    mutable std::map<term, term_set> first_set_cache;
-    term_set const &first_set(grammar const &g, term const &x){
-        std::set<term> s;
-        auto p = first_set_cache.insert(std::make_pair(x, term_set()));
-        if(p.second){
-            p.first->second = first_set_impl(g, x, s);
+    // f[x] |= f[y] for every y reachable from x by relation (DeRemer and
+    // Pennello's digraph), nodes of one strongly connected component end up
+    // with the same set.
+    static void digraph(std::vector<std::vector<std::size_t>> const &relation, std::vector<dynamic_bitset> &f){
+        std::size_t const done = (std::numeric_limits<std::size_t>::max)();
+        std::vector<std::size_t> depth(f.size(), 0), stack;
+        struct frame{
+            std::size_t node, edge, depth;
+        };
+        std::vector<frame> call;
+        auto push = [&](std::size_t x){
+            stack.push_back(x);
+            depth[x] = stack.size();
+            call.push_back(frame{ x, 0, stack.size() });
+        };
+        for(std::size_t x = 0; x < f.size(); ++x){
+            if(depth[x] != 0){
+                continue;
+            }
+            push(x);
+            while(!call.empty()){
+                frame &c = call.back();
+                std::size_t v = c.node;
+                if(c.edge < relation[v].size()){
+                    std::size_t w = relation[v][c.edge++];
+                    if(depth[w] == 0){
+                        push(w);
+                    }else{
+                        depth[v] = (std::min)(depth[v], depth[w]);
+                        f[v].merge(f[w]);
+                    }
+                    continue;
+                }
+                if(depth[v] == c.depth){
+                    std::size_t w;
+                    do{
+                        w = stack.back();
+                        stack.pop_back();
+                        depth[w] = done;
+                        if(w != v){
+                            f[w] = f[v];
+                        }
+                    }while(w != v);
+                }
+                call.pop_back();
+                if(!call.empty()){
+                    std::size_t u = call.back().node;
+                    depth[u] = (std::min)(depth[u], depth[v]);
+                    f[u].merge(f[v]);
+                }
+            }
         }
-        return p.first->second;
     }
 
-    static term_set first_set_impl(grammar const &g, term const &x, std::set<term> &scanned){
-        term_set r;
-        if(is_terminal_symbol_functor()(x, g)){
-            r.insert(x);
-            return r;
+    // nullable, FIRST and FOLLOW over dense symbol numbers.
+    // terminals and eos come first in term order, then the nonterminals in
+    // grammar order. FIRST and FOLLOW are solved by digraph, so each strongly
+    // connected component of the dependency graph is visited once.
+    class grammar_analysis{
+    public:
+        using symbol_id = std::uint32_t;
+
+        grammar_analysis(grammar const &g) : g(g){
+            term_set t = make_terminal_symbol_set(g);
+            t.insert(eos_functor()());
+            terminals.assign(t.begin(), t.end());
+            symbol_terms = terminals;
+            for(auto const &r : g){
+                symbol_terms.push_back(r.first);
+            }
+            for(term const &x : symbol_terms){
+                symbol_index.insert(std::make_pair(x, static_cast<symbol_id>(symbol_index.size())));
+            }
+            make_nullable();
+            make_first();
         }
-        if(scanned.find(x) != scanned.end()){
-            return r;
+
+        bool is_terminal(symbol_id x) const{
+            return x < terminals.size();
         }
-        scanned.insert(x);
-        rule_rhs const &rhs(g.find(x)->second);
-        auto iter = rhs.begin();
-        for(; iter != rhs.end(); ++iter){
-            if(iter->empty()){
-                r.insert(epsilon_functor()());
-                continue;
-            }
-            auto jter = iter->begin();
-            bool epsilon = true;
-            for(; epsilon && jter != iter->end(); ++jter){
-                term_set s = first_set_impl(g, *jter, scanned);
-                epsilon = s.find(epsilon_functor()()) != s.end();
-                if(epsilon){
-                    s.erase(epsilon_functor()());
+
+        symbol_id index(term const &x) const{
+            return symbol_index.find(x)->second;
+        }
+
+        void make_follow(term const &start){
+            follow.assign(symbol_terms.size(), dynamic_bitset(terminals.size()));
+            follow[index(start)].set(index(eos_functor()()));
+            std::vector<std::vector<std::size_t>> relation(symbol_terms.size());
+            for(auto const &r : g){
+                symbol_id a = index(r.first);
+                for(auto const &rr : r.second){
+                    dynamic_bitset f(terminals.size());
+                    bool epsilon = true;
+                    for(auto iter = rr.rbegin(); iter != rr.rend(); ++iter){
+                        symbol_id x = index(*iter);
+                        if(!is_terminal(x)){
+                            follow[x].merge(f);
+                            if(epsilon){
+                                relation[x].push_back(a);
+                            }
+                        }
+                        if(is_terminal(x) || !nullable.test(x)){
+                            f.clear();
+                            epsilon = false;
+                        }
+                        f.merge(first[x]);
+                    }
                 }
-                r = union_set(r, s);
             }
-            if(epsilon && jter == iter->end()){
+            digraph(relation, follow);
+        }
+
+        // as term_set, FIRST contains epsilon if x is nullable.
+        term_set first_set(term const &x) const{
+            symbol_id i = index(x);
+            term_set r = to_term_set(first[i]);
+            if(!is_terminal(i) && nullable.test(i)){
                 r.insert(epsilon_functor()());
             }
+            return r;
         }
-        return r;
-    }
 
-    std::map<term, term_set> follow_set;
-    void make_follow_set(grammar const &g, term const &s){
-        follow_set[s].insert(eos_functor()());
-        std::size_t size = 0, psize;
-        do{
-            psize = size;
-            for(std::pair<term, rule_rhs> const &p : g){
-                for(term_sequence const &seq : p.second){
-                    if(seq.size() < 2){ continue; }
-                    for(auto iter = seq.rbegin() + 1; iter != seq.rend() - 1; ++iter){
-                        term const &b = *iter, &beta = *(iter - 1);
-                        if(is_terminal_symbol_functor()(b, g)){ continue; }
-                        term_set &b_set = follow_set[b];
-                        std::size_t b_size = b_set.size();
-                        for(auto jter = iter; ; ){
-                            if(jter == seq.rbegin()){ break; }
-                            --jter;
-                            term_set const &first_beta(first_set(g, *jter));
-                            b_set.insert(first_beta.begin(), first_beta.end());
-                            if(b_set.find(epsilon_functor()()) != b_set.end()){
-                                b_set.erase(epsilon_functor()());
-                            }
-                            size += b_set.size() - b_size;
-                            b_size = b_set.size();
+        term_set follow_set(term const &x) const{
+            return to_term_set(follow[index(x)]);
+        }
+
+        term_set to_term_set(dynamic_bitset const &b) const{
+            term_set r;
+            b.for_each([&](std::size_t t){
+                r.insert(r.end(), terminals[t]);
+            });
+            return r;
+        }
+
+        grammar const &g;
+        std::vector<term> terminals, symbol_terms;
+        std::map<term, symbol_id> symbol_index;
+        dynamic_bitset nullable;
+        std::vector<dynamic_bitset> first, follow;
+
+    private:
+        // a production becomes nullable when its count of not yet nullable
+        // symbols drops to zero.
+        void make_nullable(){
+            std::size_t const has_terminal = (std::numeric_limits<std::size_t>::max)();
+            nullable.resize(symbol_terms.size());
+            std::vector<std::vector<std::size_t>> occurrence(symbol_terms.size());
+            std::vector<std::size_t> rest;
+            std::vector<symbol_id> lhs, queue;
+            for(auto const &r : g){
+                for(auto const &rr : r.second){
+                    std::size_t p = rest.size(), count = 0;
+                    lhs.push_back(index(r.first));
+                    for(term const &x : rr){
+                        symbol_id i = index(x);
+                        if(is_terminal(i)){
+                            count = has_terminal;
+                            break;
                         }
+                        occurrence[i].push_back(p);
+                        ++count;
+                    }
+                    rest.push_back(count);
+                    if(count == 0 && nullable.set(lhs[p])){
+                        queue.push_back(lhs[p]);
                     }
                 }
             }
-            for(std::pair<term, rule_rhs> const &p : g){
-                for(term_sequence const &seq : p.second){
-                    if(seq.empty()){ continue; }
-                    term_set const &a_set = follow_set[p.first];
-                    if(!is_terminal_symbol_functor()(seq.back(), g)){
-                        term const &b = seq.back();
-                        term_set &b_set = follow_set[b];
-                        std::size_t b_size = b_set.size();
-                        b_set.insert(a_set.begin(), a_set.end());
-                        size += b_set.size() - b_size;
-                    }
-                    if(seq.size() == 1){ continue; }
-                    for(auto iter = seq.rbegin() + 1; iter != seq.rend() - 1; ++iter){
-                        term const &b = *iter, &beta = *(iter - 1);
-                        if(is_terminal_symbol_functor()(b, g)){ continue; }
-                        term_set &b_set = follow_set[b];
-                        std::size_t b_size = b_set.size();
-                        for(auto jter = iter; ; ){
-                            if(jter == seq.rbegin()){ break; }
-                            --jter;
-                            term_set const &first_beta(first_set(g, *jter));
-                            bool epsilon = first_beta.find(epsilon_functor()()) != first_beta.end();
-                            if(epsilon){
-                                b_set.insert(a_set.begin(), a_set.end());
-                                size += b_set.size() - b_size;
-                                b_size = b_set.size();
-                            }
+            while(!queue.empty()){
+                symbol_id a = queue.back();
+                queue.pop_back();
+                for(std::size_t p : occurrence[a]){
+                    if(rest[p] != has_terminal && --rest[p] == 0 && nullable.set(lhs[p])){
+                        queue.push_back(lhs[p]);
+                    }
+                }
+            }
+        }
+
+        void make_first(){
+            first.assign(symbol_terms.size(), dynamic_bitset(terminals.size()));
+            std::vector<std::vector<std::size_t>> relation(symbol_terms.size());
+            for(symbol_id x = 0; x < terminals.size(); ++x){
+                first[x].set(x);
+            }
+            for(auto const &r : g){
+                symbol_id a = index(r.first);
+                for(auto const &rr : r.second){
+                    for(term const &x : rr){
+                        symbol_id i = index(x);
+                        if(is_terminal(i)){
+                            first[a].set(i);
+                            break;
+                        }
+                        relation[a].push_back(i);
+                        if(!nullable.test(i)){
+                            break;
                         }
                     }
                 }
             }
-        }while(size != psize);
+            digraph(relation, first);
+        }
+    };
+
+    std::unique_ptr<grammar_analysis> analysis_cache;
+    grammar_analysis &analysis(grammar const &g){
+        if(!analysis_cache || &analysis_cache->g != &g){
+            analysis_cache.reset(new grammar_analysis(g));
+            first_set_cache.clear();
+        }
+        return *analysis_cache;
+    }
+
+    mutable std::map<term, term_set> first_set_cache;
+    term_set const &first_set(grammar const &g, term const &x){
+        grammar_analysis const &a = analysis(g);
+        auto p = first_set_cache.insert(std::make_pair(x, term_set()));
+        if(p.second){
+            p.first->second = a.first_set(x);
+        }
+        return p.first->second;
+    }
+
+    std::map<term, term_set> follow_set;
+    void make_follow_set(grammar const &g, term const &s){
+        grammar_analysis &a = analysis(g);
+        a.make_follow(s);
+        follow_set.clear();
+        for(auto const &r : g){
+            follow_set[r.first] = a.follow_set(r.first);
+        }
     }
 
     static items lr0_closure(grammar const &g, items j){
@@ -493,32 +725,67 @@ public:
         return lr0_closure(g, r);
     }
 
-    static states lr0_items(grammar const &g, term_set const &terminal_symbol_set, item const &start){
+    // f(0) ... f(n - 1) on up to jobs threads.
+    template<class F>
+    static void parallel_for(std::size_t n, std::size_t jobs, F f){
+        if(jobs <= 1 || n <= 1){
+            for(std::size_t i = 0; i < n; ++i){
+                f(i);
+            }
+            return;
+        }
+        std::atomic<std::size_t> next(0);
+        auto worker = [&](){
+            for(std::size_t i; (i = next++) < n; ){
+                f(i);
+            }
+        };
+        std::vector<std::thread> threads;
+        for(std::size_t t = 1; t < jobs && t < n; ++t){
+            threads.emplace_back(worker);
+        }
+        worker();
+        for(std::thread &t : threads){
+            t.join();
+        }
+    }
+
+    // the gotos of the states found in the previous round are computed in
+    // parallel and interned serially, c is ordered by items_comparetor so the
+    // result does not depend on jobs.
+    static states lr0_items(grammar const &g, term_set const &terminal_symbol_set, item const &start, std::size_t jobs = 1){
         states c;
+        std::vector<items const*> frontier;
         {
             items init;
             init.insert(start);
-            c.insert(lr0_closure(g, init));
+            frontier.push_back(&*c.insert(lr0_closure(g, init)).first);
         }
-        std::size_t size;
-        do{
-            size = c.size();
-            for(auto iter = c.begin(); iter != c.end(); ++iter){
-                items const &i(*iter);
-                auto lambda = [&](term const &x){
-                    items n_items = lr0_goto(g, i, x);
-                    if(!n_items.empty() && c.find(n_items) == c.end()){
-                        c.insert(n_items);
+        std::vector<term> symbols;
+        for(auto gter = g.begin(); gter != g.end(); ++gter){
+            symbols.push_back(gter->first);
+        }
+        symbols.insert(symbols.end(), terminal_symbol_set.begin(), terminal_symbol_set.end());
+        while(!frontier.empty()){
+            std::vector<std::vector<items>> n_items(frontier.size());
+            parallel_for(frontier.size(), jobs, [&](std::size_t n){
+                for(term const &x : symbols){
+                    items r = lr0_goto(g, *frontier[n], x);
+                    if(!r.empty()){
+                        n_items[n].push_back(std::move(r));
                     }
-                };
-                for(auto gter = g.begin(); gter != g.end(); ++gter){
-                    lambda(gter->first);
                 }
-                for(auto xter = terminal_symbol_set.begin(); xter != terminal_symbol_set.end(); ++xter){
-                    lambda(*xter);
+            });
+            frontier.clear();
+            for(auto &v : n_items){
+                for(items &i : v){
+                    auto p = c.insert(std::move(i));
+                    if(p.second){
+                        frontier.push_back(&*p.first);
+                    }
                 }
             }
-        }while(size != c.size());
+        }
         return c;
     }
 
@@ -537,22 +804,14 @@ public:
                 rule_rhs const &rule(g.find(i_item.curr())->second);
                 for(auto jter = rule.begin(); jter != rule.end(); ++jter){
                     term_set first_beta_a;
-                    if(i_item.pos + 1 < i_item.rhs.size()){
-                        for(std::size_t n = i_item.pos + 1; n < i_item.rhs.size(); ++n){
-                            term_set const &f = first_set(g, i_item.rhs[n]);
-                            bool epsilon = f.find(epsilon_functor()()) != f.end();
-                            for(term const &fe : f){
-                                first_beta_a.insert(fe);
-                            }
-                            if(!epsilon){
-                                break;
-                            }
-                        }
+                    bool epsilon = true;
+                    for(std::size_t n = i_item.pos + 1; epsilon && n < i_item.rhs.size(); ++n){
+                        term_set const &f = first_set(g, i_item.rhs[n]);
+                        epsilon = f.find(epsilon_functor()()) != f.end();
+                        first_beta_a.insert(f.begin(), f.end());
                     }
-                    if(first_beta_a.empty()){
-                        first_beta_a = i_item.lookahead;
-                    }else if(first_beta_a.find(epsilon_functor()()) != first_beta_a.end()){
-                        first_beta_a.erase(epsilon_functor()());
+                    first_beta_a.erase(epsilon_functor()());
+                    if(epsilon){
                         first_beta_a.insert(i_item.lookahead.begin(), i_item.lookahead.end());
                     }
                     item t;
@@ -625,8 +884,8 @@ public:
         return i;
     }
 
-    static void lr0_kernel_items(grammar const &g, states &c_prime, states &c, typename states::iterator &first_state, term_set const &terminal_symbol_set, item const &start){
-        c_prime = lr0_items(g, terminal_symbol_set, start);
+    static void lr0_kernel_items(grammar const &g, states &c_prime, states &c, typename states::iterator &first_state, term_set const &terminal_symbol_set, item const &start, std::size_t jobs = 1){
+        c_prime = lr0_items(g, terminal_symbol_set, start, jobs);
         for(items const &i : c_prime){
             std::pair<states::iterator, bool> p = c.insert(kernel_filter(i, start));
             p.first->mirror = &i;
@@ -634,6 +893,7 @@ public:
             if(
                 p.first->size() == 1 &&
                 p.first->begin()->lhs == -1 &&
+                p.first->begin()->pos == 0 &&
                 p.first->begin()->rhs.size() == 1 &&
                 *p.first->begin()->rhs.begin() == -2
             ){
@@ -642,12 +902,18 @@ public:
         }
     }
 
-    static void make_goto_map(grammar const &g, term_set const &h, states const &c_prime, states const &c, item const &start){
+    static void make_goto_map(grammar const &g, term_set const &h, states const &c_prime, states const &c, item const &start, std::size_t jobs = 1){
         term_set k;
         for(auto const &r : g){
             k.insert(r.first);
         }
+        // each state writes only its own mirror's goto_map.
+        std::vector<items const*> c_prime_seq;
         for(items const &s : c_prime){
+            c_prime_seq.push_back(&s);
+        }
+        parallel_for(c_prime_seq.size(), jobs, [&](std::size_t n){
+            items const &s(*c_prime_seq[n]);
             auto f = [&](term_set const &ts){
                 for(term const &t : ts){
                     items n_goto = kernel_filter(lr0_goto(g, s, t), start);
@@ -659,7 +925,7 @@ public:
             };
             f(h);
             f(k);
-        }
+        });
     }
 
     void completion_lookahead(grammar const &g, states &s, typename states::iterator first_state, item const &start){
@@ -713,20 +979,155 @@ public:
 
     states c_closure(grammar const &g, states const &c, typename states::iterator &first_state, typename items::iterator &first_item){
         states c_prime;
+        std::unordered_map<items const*, items const*> kernel_to_closure;
         for(items const &s : c){
             items t = lr1_closure(g, s);
             if(first_state != c.end() && &s == &*first_state){
-                c_prime.insert(t);
-                typename states::iterator tmp_iter = c_prime.find(t);
+                typename states::iterator tmp_iter = c_prime.insert(std::move(t)).first;
                 first_item = tmp_iter->find(*first_state->begin());
                 first_state = tmp_iter;
+                kernel_to_closure[&s] = &*tmp_iter;
             }else{
-                c_prime.insert(std::move(t));
+                kernel_to_closure[&s] = &*c_prime.insert(std::move(t)).first;
+            }
+        }
+        // goto_map still points into c.
+        for(items const &s : c_prime){
+            for(auto &p : s.goto_map){
+                p.second = kernel_to_closure[p.second];
             }
         }
         return c_prime;
     }
 
+    class lr_parsing_table_maker{
+    public:
+        lr_parsing_table_maker(grammar const &g, symbol_data_map const &symbol_data, lr_parsing_table &parsing_table, lr_conflict_set &conflict_set) :
+            g(g), symbol_data(symbol_data), parsing_table(parsing_table), conflict_set(conflict_set)
+        {}
+
+        void accept(std::size_t state_num, item const &i){
+            lr_parsing_table_item a;
+            a.action = lr_parsing_table_item::enum_action::accept;
+            a.num = 0;
+            a.item_ptr = &i;
+            auto p = parsing_table[state_num].insert(std::make_pair(eos_functor()(), a));
+            if(!p.second){
+                insert_conflict(p.first->second, a);
+            }
+        }
+
+        void reduce(std::size_t state_num, std::size_t rule_num, item const &i){
+            lr_parsing_table_item a;
+            a.action = lr_parsing_table_item::enum_action::reduce;
+            a.num = rule_num;
+            a.item_ptr = &i;
+            for(term const &t : i.lookahead){
+                auto &parsing_table_item = parsing_table[state_num];
+                auto p = parsing_table_item.insert(std::make_pair(t, a));
+                if(!p.second){
+                    lr_parsing_table_item const &other = p.first->second;
+                    if(other.action == lr_parsing_table_item::enum_action::reduce){
+                        insert_conflict(other, a);
+                    }else{
+                        term const &tag = i.rhs.tag, &other_tag = other.item_ptr->rhs.tag;
+                        symbol_data_type symbol_data, other_symbol_data;
+                        if(tag == epsilon_functor()()){
+                            symbol_data = priority_sup(i.rhs);
+                        }else{
+                            symbol_data = this->symbol_data.find(tag)->second;
+                        }
+                        if(other_tag == epsilon_functor()()){
+                            other_symbol_data = priority_sup(other.item_ptr->rhs);
+                        }else{
+                            other_symbol_data = this->symbol_data.find(other_tag)->second;
+                        }
+                        if(symbol_data.priority > other_symbol_data.priority){
+                            p.first->second = a;
+                        }else if(symbol_data.priority == other_symbol_data.priority){
+                            if(symbol_data.dir == linkdir::left){
+                                if(other_symbol_data.dir != linkdir::left){
+                                    p.first->second = a;
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        void shift(std::size_t state_num, std::size_t goto_num, item const &i){
+            lr_parsing_table_item a;
+            a.action = lr_parsing_table_item::enum_action::shift;
+            a.num = goto_num;
+            a.item_ptr = &i;
+            auto &parsing_table_item = parsing_table[state_num];
+            auto p = parsing_table_item.insert(std::make_pair(i.curr(), a));
+            if(!p.second){
+                lr_parsing_table_item const &other = p.first->second;
+                if(other.action == lr_parsing_table_item::enum_action::reduce){
+                    symbol_data_type symbol_data, other_symbol_data;
+                    term const &tag = a.item_ptr->rhs.tag;
+                    auto iter = this->symbol_data.find(tag), other_iter = this->symbol_data.find(i.curr());
+                    if(iter != this->symbol_data.end()){
+                        symbol_data = iter->second;
+                    }else{
+                        symbol_data = priority_sup(i.rhs);
+                    }
+                    if(other_iter != this->symbol_data.end()){
+                        other_symbol_data = other_iter->second;
+                    }
+                    if(symbol_data.priority == other_symbol_data.priority){
+                        if(symbol_data.dir == linkdir::right){
+                            if(other_symbol_data.dir != linkdir::right){
+                                p.first->second = a;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        symbol_data_type priority_sup(term_sequence const &seq) const{
+            symbol_data_type p;
+            for(auto &t : seq){
+                if(!is_terminal_symbol_functor()(t, g)){ continue; }
+                auto iter = symbol_data.find(t);
+                if(iter == symbol_data.end()){ continue; }
+                symbol_data_type const &data = iter->second;
+                if(data.priority > p.priority){
+                    p = data;
+                }
+            }
+            return p;
+        }
+
+        void insert_conflict(lr_parsing_table_item const &x, lr_parsing_table_item const &y){
+            if(lr_parsing_table_item_comparetor()(x, y)){
+                conflict_set.insert(lr_conflict({ x, y }));
+            }else{
+                conflict_set.insert(lr_conflict({ y, x }));
+            }
+        }
+
+        grammar const &g;
+        symbol_data_map const &symbol_data;
+        lr_parsing_table &parsing_table;
+        lr_conflict_set &conflict_set;
+    };
+
+    static void make_rule_num(grammar const &g, rule_to_num &r2n, num_to_rule &n2r){
+        std::size_t i = 0;
+        for(auto const &r : g){
+            for(auto const &rr : r.second){
+                n2r[i] = std::make_pair(r.first, &rr);
+                r2n[&rr] = i;
+                ++i;
+            }
+        }
+    }
+
     make_result make2(
         grammar const &g,
         states const &c,
@@ -738,24 +1139,17 @@ public:
         lr0_kernel_states s_prime;
         rule_to_num &r2n(result.r2n);
         num_to_rule &n2r(result.n2r);
-        {
-            std::size_t i = 0;
-            for(auto const &r : g){
-                for(auto const &rr : r.second){
-                    n2r[i] = std::make_pair(r.first, &rr);
-                    r2n[&rr] = i;
-                    ++i;
-                }
-            }
-        }
+        make_rule_num(g, r2n, n2r);
         state_to_num &s2n(result.s2n);
         num_to_state &n2s(result.n2s);
+        std::unordered_map<items const*, std::size_t> ptr_to_num;
         {
             std::size_t i = 0;
             if(first_state != c.end()){
                 s_prime.insert(&*first_state);
                 s2n[&*first_state] = i;
                 n2s[i] = &*first_state;
+                ptr_to_num[&*first_state] = i;
                 ++i;
             }
             for(auto const &s : c){
@@ -765,136 +1159,526 @@ public:
                 s_prime.insert(&s);
                 s2n[&s] = i;
                 n2s[i] = &s;
+                ptr_to_num[&s] = i;
                 ++i;
             }
         }
-        lr_parsing_table &parsing_table(result.parsing_table);
-        lr_conflict_set &conflict_set(result.conflict_set);
-        auto priority_sup = [&](term_sequence const &seq){
-            symbol_data_type p;
-            for(auto &t : seq){
-                if(!is_terminal_symbol_functor()(t, g)){ continue; }
-                auto iter = symbol_data_map.find(t);
-                if(iter == symbol_data_map.end()){ continue; }
-                symbol_data_type const &data = iter->second;
-                if(data.priority > p.priority){
-                    p = data;
-                }
-            }
-            return p;
-        };
-        auto insert_conflict = [&](lr_parsing_table_item const &x, lr_parsing_table_item const &y){
-            if(lr_parsing_table_item_comparetor()(x, y)){
-                conflict_set.insert(lr_conflict({ x, y }));
-            }else{
-                conflict_set.insert(lr_conflict({ y, x }));
-            }
-        };
-
+        // transitions come from the goto_map of each state which c_closure
+        // has carried over from make_goto_map.
+        lr_parsing_table_maker maker(g, symbol_data_map, result.parsing_table, result.conflict_set);
         for(items const &state : c){
+            std::size_t state_num = ptr_to_num[&state];
             for(item const &i : state){
                 if(i.is_over()){
                     if(i.lhs == start.lhs && i.rhs == start.rhs && i.lookahead == start.lookahead){
                         // accept
-                        lr_parsing_table_item a;
-                        a.action = lr_parsing_table_item::enum_action::accept;
-                        a.num = 0;
-                        a.item_ptr = &i;
-                        auto p = parsing_table[s2n[&state]].insert(std::make_pair(eos_functor()(), a));
-                        if(!p.second){
-                            insert_conflict(p.first->second, a);
-                        }
+                        maker.accept(state_num, i);
                     }else{
                         // reduce
-                        lr_parsing_table_item a;
-                        a.action = lr_parsing_table_item::enum_action::reduce;
-                        a.num = r2n[&*g.find(i.lhs)->second.find(i.rhs)];
-                        a.item_ptr = &i;
-                        for(term const &t : i.lookahead){
-                            auto &parsing_table_item = parsing_table[s2n[&state]];
-                            auto p = parsing_table_item.insert(std::make_pair(t, a));
-                            if(!p.second){
-                                lr_parsing_table_item const &other = p.first->second;
-                                if(other.action == lr_parsing_table_item::enum_action::reduce){
-                                    insert_conflict(other, a);
-                                }else{
-                                    term const &tag = i.rhs.tag, &other_tag = other.item_ptr->rhs.tag;
-                                    symbol_data_type symbol_data, other_symbol_data;
-                                    if(tag == epsilon_functor()()){
-                                        symbol_data = priority_sup(i.rhs);
-                                    }else{
-                                        symbol_data = symbol_data_map.find(tag)->second;
-                                    }
-                                    if(other_tag == epsilon_functor()()){
-                                        other_symbol_data = priority_sup(other.item_ptr->rhs);
-                                    }else{
-                                        other_symbol_data = symbol_data_map.find(other_tag)->second;
-                                    }
-                                    if(symbol_data.priority > other_symbol_data.priority){
-                                        p.first->second = a;
-                                    }else if(symbol_data.priority == other_symbol_data.priority){
-                                        if(symbol_data.dir == linkdir::left){
-                                            if(other_symbol_data.dir != linkdir::left){
-                                                p.first->second = a;
-                                            }
-                                        }
-                                    }
-                                }
-                            }
-                        }
+                        maker.reduce(state_num, r2n[&*g.find(i.lhs)->second.find(i.rhs)], i);
                     }
                 }else{
                     if(is_terminal_symbol_functor()(i.curr(), g)){
                         // shift
-                        lr_parsing_table_item a;
-                        items n_goto = lr0_goto(g, state, i.curr());
-                        a.action = lr_parsing_table_item::enum_action::shift;
-                        a.num = s2n[&n_goto];
-                        a.item_ptr = &i;
-                        auto &parsing_table_item = parsing_table[s2n[&state]];
-                        auto p = parsing_table_item.insert(std::make_pair(i.curr(), a));
-                        if(!p.second){
-                            lr_parsing_table_item const &other = p.first->second;
-                            if(other.action == lr_parsing_table_item::enum_action::reduce){
-                                symbol_data_type symbol_data, other_symbol_data;
-                                term const &tag = a.item_ptr->rhs.tag;
-                                auto iter = symbol_data_map.find(tag), other_iter = symbol_data_map.find(i.curr());
-                                if(iter != symbol_data_map.end()){
-                                    symbol_data = iter->second;
-                                }else{
-                                    symbol_data = priority_sup(i.rhs);
-                                }
-                                if(other_iter != symbol_data_map.end()){
-                                    other_symbol_data = other_iter->second;
-                                }
-                                if(symbol_data.priority == other_symbol_data.priority){
-                                    if(symbol_data.dir == linkdir::right){
-                                        if(other_symbol_data.dir != linkdir::right){
-                                            p.first->second = a;
-                                        }
-                                    }
-                                }
-                            }
-                        }
+                        maker.shift(state_num, ptr_to_num[state.goto_map.find(i.curr())->second], i);
                     }else if(i.pos == 0 && i.lhs == start.lhs && i.rhs == start.rhs && i.lookahead == start.lookahead){
-                        result.first = s2n[&state];
+                        result.first = state_num;
                     }
                 }
             }
         }
         lr_goto_table &goto_table(result.goto_table);
-        for(auto const &p : s2n){
-            auto &goto_map(goto_table[p.second]);
-            for(auto const &r : g){
-                items n_goto = lr1_goto(g, *p.first, r.first);
-                if(s2n.find(&n_goto) != s2n.end()){
-                    goto_map.insert(std::make_pair(r.first, s2n[&n_goto]));
+        for(items const &state : c){
+            auto &goto_map(goto_table[ptr_to_num[&state]]);
+            for(auto const &p : state.goto_map){
+                if(!is_terminal_symbol_functor()(p.first, g)){
+                    goto_map.insert(std::make_pair(p.first, ptr_to_num[p.second]));
                 }
             }
         }
         return result;
     }
 
+    // dense builder
+    // items are (production, dot) pairs packed into one integer, states are
+    // kernels of sorted item ids interned in a hash table and lookaheads are
+    // bitsets over the dense terminal index.
+    // make() gives the same make_result as the
+    // lr0_kernel_items -> completion_lookahead -> c_closure -> make2 pipeline.
+    class dense_builder{
+    public:
+        using symbol_id = typename grammar_analysis::symbol_id;
+        using item_id = std::uint32_t;
+        using kernel_type = std::vector<item_id>;
+
+        struct production{
+            term lhs;
+            symbol_id lhs_symbol;
+            term_sequence const *rhs;
+            std::vector<symbol_id> symbols;
+            item_id first_item;
+        };
+
+        struct transition{
+            symbol_id symbol;
+            std::size_t target;
+        };
+
+        struct state{
+            kernel_type kernel;
+            std::vector<item_id> closure;
+            std::vector<transition> transitions;
+            std::vector<std::size_t> lookahead_node;
+        };
+
+        dense_builder(grammar const &g, grammar_analysis const &analysis, item const &start) :
+            g(g),
+            terminals(analysis.terminals),
+            symbol_terms(analysis.symbol_terms),
+            symbol_index(analysis.symbol_index),
+            nullable(analysis.nullable),
+            first(analysis.first)
+        {
+            symbol_productions.resize(symbol_index.size());
+            item_id item_count = 0;
+            for(auto const &r : g){
+                for(auto const &rr : r.second){
+                    production p;
+                    p.lhs = r.first;
+                    p.lhs_symbol = symbol_index.find(r.first)->second;
+                    p.rhs = &rr;
+                    for(term const &x : rr){
+                        p.symbols.push_back(symbol_index.find(x)->second);
+                    }
+                    p.first_item = item_count;
+                    item_count += static_cast<item_id>(rr.size() + 1);
+                    if(r.first == start.lhs && rr == start.rhs){
+                        start_production = productions.size();
+                    }
+                    symbol_productions[p.lhs_symbol].push_back(productions.size());
+                    productions.push_back(std::move(p));
+                }
+            }
+            item_production.resize(item_count);
+            for(std::size_t i = 0; i < productions.size(); ++i){
+                for(std::size_t j = 0; j <= productions[i].symbols.size(); ++j){
+                    item_production[productions[i].first_item + j] = i;
+                }
+            }
+            make_first_after();
+        }
+
+        bool is_terminal(symbol_id x) const{
+            return x < terminals.size();
+        }
+
+        production const &item_to_production(item_id i) const{
+            return productions[item_production[i]];
+        }
+
+        std::size_t item_to_pos(item_id i) const{
+            return i - item_to_production(i).first_item;
+        }
+
+        bool item_is_over(item_id i) const{
+            return item_to_pos(i) >= item_to_production(i).symbols.size();
+        }
+
+        symbol_id item_curr(item_id i) const{
+            return item_to_production(i).symbols[item_to_pos(i)];
+        }
+
+        // LR(0) canonical collection.
+        void make_lr0(){
+            std::unordered_map<kernel_type, std::size_t, kernel_hash> kernel_to_state;
+            {
+                state s;
+                s.kernel.push_back(productions[start_production].first_item);
+                kernel_to_state.insert(std::make_pair(s.kernel, 0));
+                dense_states.push_back(std::move(s));
+            }
+            std::vector<kernel_type> goto_kernel(symbol_index.size());
+            std::vector<symbol_id> touched;
+            for(std::size_t n = 0; n < dense_states.size(); ++n){
+                make_closure(dense_states[n]);
+                touched.clear();
+                for(item_id i : dense_states[n].closure){
+                    if(item_is_over(i)){
+                        continue;
+                    }
+                    symbol_id x = item_curr(i);
+                    if(goto_kernel[x].empty()){
+                        touched.push_back(x);
+                    }
+                    goto_kernel[x].push_back(i + 1);
+                }
+                std::sort(touched.begin(), touched.end());
+                for(symbol_id x : touched){
+                    kernel_type &k = goto_kernel[x];
+                    std::sort(k.begin(), k.end());
+                    auto p = kernel_to_state.insert(std::make_pair(k, dense_states.size()));
+                    if(p.second){
+                        state s;
+                        s.kernel = k;
+                        dense_states.push_back(std::move(s));
+                    }
+                    dense_states[n].transitions.push_back(transition{ x, p.first->second });
+                    k.clear();
+                }
+            }
+        }
+
+        // LALR(1) lookahead, propagated over kernel items and (state, nonterminal) pairs.
+        void make_lookahead(){
+            make_lookahead_node();
+            std::vector<std::vector<std::size_t>> edge(lookahead.size());
+            for(std::size_t n = 0; n < dense_states.size(); ++n){
+                state &s = dense_states[n];
+                for(std::size_t k = 0; k < s.closure.size(); ++k){
+                    item_id i = s.closure[k];
+                    std::size_t src = s.lookahead_node[k];
+                    if(item_is_over(i)){
+                        continue;
+                    }
+                    symbol_id x = item_curr(i);
+                    edge[src].push_back(find_kernel_node(find_transition(s, x)->target, i + 1));
+                    if(!is_terminal(x)){
+                        std::size_t dest = find_nonterminal_node(n, x);
+                        lookahead[dest].merge(first_after[i]);
+                        if(nullable_after.test(i)){
+                            edge[src].push_back(dest);
+                        }
+                    }
+                }
+            }
+            lookahead[start_node].set(symbol_index.find(eos_functor()())->second);
+            propagate(edge);
+        }
+
+        // LALR(1) lookahead by DeRemer and Pennello's relations.
+        // (state, nonterminal) nodes are the nonterminal transitions, Read and
+        // Follow are solved by digraph over reads and includes and the kernel
+        // items take the union of Follow over their lookback transitions.
+        void make_lookahead_deremer_pennello(){
+            make_lookahead_node();
+            std::vector<std::vector<std::size_t>> reads(lookahead.size()), includes(lookahead.size()), lookback(lookahead.size());
+            // DR and reads.
+            for(std::size_t n = 0; n < dense_states.size(); ++n){
+                for(auto const &a : nonterminal_node[n]){
+                    std::size_t r = find_transition(dense_states[n], a.first)->target;
+                    for(transition const &t : dense_states[r].transitions){
+                        if(is_terminal(t.symbol)){
+                            lookahead[a.second].set(t.symbol);
+                        }else if(nullable.test(t.symbol)){
+                            reads[a.second].push_back(find_nonterminal_node(r, t.symbol));
+                        }
+                    }
+                }
+            }
+            lookahead[start_node].set(symbol_index.find(eos_functor()())->second);
+            digraph(reads, lookahead);
+            // includes and lookback.
+            auto walk = [&](std::size_t n, std::size_t node, production const &prod){
+                std::size_t r = n;
+                for(std::size_t j = 0; j < prod.symbols.size(); ++j){
+                    symbol_id x = prod.symbols[j];
+                    if(!is_terminal(x) && nullable_after.test(prod.first_item + j)){
+                        includes[find_nonterminal_node(r, x)].push_back(node);
+                    }
+                    r = find_transition(dense_states[r], x)->target;
+                    lookback[node].push_back(find_kernel_node(r, prod.first_item + static_cast<item_id>(j + 1)));
+                }
+            };
+            walk(0, start_node, productions[start_production]);
+            for(std::size_t n = 0; n < dense_states.size(); ++n){
+                for(auto const &a : nonterminal_node[n]){
+                    for(std::size_t p : symbol_productions[a.first]){
+                        walk(n, a.second, productions[p]);
+                    }
+                }
+            }
+            digraph(includes, lookahead);
+            for(std::size_t node = 0; node < lookback.size(); ++node){
+                for(std::size_t k : lookback[node]){
+                    lookahead[k].merge(lookahead[node]);
+                }
+            }
+        }
+
+        // materialize the states into c and make the parsing table.
+        make_result make(states &c, bool first_state_is_zero, symbol_data_map const &symbol_data_map){
+            make_result result;
+            make_rule_num(g, result.r2n, result.n2r);
+            c.clear();
+            std::vector<std::size_t> order(dense_states.size());
+            for(std::size_t n = 0; n < order.size(); ++n){
+                order[n] = n;
+            }
+            std::sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y){ return state_less(x, y); });
+            std::unordered_map<items const*, std::size_t> ptr_to_state;
+            std::vector<items const*> state_to_ptr(dense_states.size());
+            for(std::size_t n : order){
+                typename states::iterator iter = c.emplace_hint(c.end(), materialize(n));
+                ptr_to_state.insert(std::make_pair(&*iter, n));
+                state_to_ptr[n] = &*iter;
+            }
+            std::vector<std::size_t> num(dense_states.size());
+            {
+                std::size_t i = 0;
+                auto numbering = [&](items const *p){
+                    result.s2n[p] = i;
+                    result.n2s[i] = p;
+                    num[ptr_to_state[p]] = i;
+                    ++i;
+                };
+                if(first_state_is_zero){
+                    numbering(state_to_ptr[0]);
+                }
+                for(auto const &s : c){
+                    if(first_state_is_zero && &s == state_to_ptr[0]){
+                        continue;
+                    }
+                    numbering(&s);
+                }
+            }
+            for(std::size_t n = 0; n < dense_states.size(); ++n){
+                for(transition const &t : dense_states[n].transitions){
+                    state_to_ptr[n]->goto_map[symbol_terms[t.symbol]] = state_to_ptr[t.target];
+                }
+            }
+            lr_parsing_table_maker maker(g, symbol_data_map, result.parsing_table, result.conflict_set);
+            dynamic_bitset const &start_lookahead = lookahead[start_node];
+            for(items const &st : c){
+                std::size_t n = ptr_to_state[&st];
+                state const &s = dense_states[n];
+                std::size_t k = 0;
+                for(auto iter = st.begin(); iter != st.end(); ++iter, ++k){
+                    item_id i = s.closure[k];
+                    bool is_start = item_production[i] == start_production && lookahead[s.lookahead_node[k]] == start_lookahead;
+                    if(item_is_over(i)){
+                        if(is_start){
+                            maker.accept(num[n], *iter);
+                        }else{
+                            maker.reduce(num[n], item_production[i], *iter);
+                        }
+                    }else{
+                        symbol_id x = item_curr(i);
+                        if(is_terminal(x)){
+                            maker.shift(num[n], num[find_transition(s, x)->target], *iter);
+                        }else if(item_to_pos(i) == 0 && is_start){
+                            result.first = num[n];
+                        }
+                    }
+                }
+                auto &goto_map(result.goto_table[num[n]]);
+                for(transition const &t : s.transitions){
+                    if(!is_terminal(t.symbol)){
+                        goto_map.insert(std::make_pair(symbol_terms[t.symbol], num[t.target]));
+                    }
+                }
+            }
+            return result;
+        }
+
+    private:
+        struct kernel_hash{
+            std::size_t operator ()(kernel_type const &k) const{
+                std::size_t h = k.size();
+                for(item_id i : k){
+                    h = h * 31 + i;
+                }
+                return h;
+            }
+        };
+
+        typename std::vector<transition>::const_iterator find_transition(state const &s, symbol_id x) const{
+            return std::lower_bound(s.transitions.begin(), s.transitions.end(), x, [](transition const &t, symbol_id x){ return t.symbol < x; });
+        }
+
+        // FIRST of the remaining rhs of each item.
+        void make_first_after(){
+            first_after.assign(item_production.size(), dynamic_bitset(terminals.size()));
+            nullable_after.resize(item_production.size());
+            for(production const &p : productions){
+                dynamic_bitset f(terminals.size());
+                bool epsilon = true;
+                for(std::size_t j = p.symbols.size(); j > 0; --j){
+                    item_id i = p.first_item + static_cast<item_id>(j - 1);
+                    first_after[i] = f;
+                    if(epsilon){
+                        nullable_after.set(i);
+                    }
+                    symbol_id x = p.symbols[j - 1];
+                    if(is_terminal(x) || !nullable.test(x)){
+                        f.clear();
+                        epsilon = false;
+                    }
+                    f.merge(first[x]);
+                }
+            }
+        }
+
+        void make_closure(state &s) const{
+            dynamic_bitset visited(symbol_index.size());
+            std::vector<symbol_id> stack;
+            s.closure = s.kernel;
+            for(item_id i : s.kernel){
+                if(!item_is_over(i) && !is_terminal(item_curr(i)) && visited.set(item_curr(i))){
+                    stack.push_back(item_curr(i));
+                }
+            }
+            while(!stack.empty()){
+                symbol_id a = stack.back();
+                stack.pop_back();
+                for(std::size_t p : symbol_productions[a]){
+                    production const &prod = productions[p];
+                    s.closure.push_back(prod.first_item);
+                    if(!prod.symbols.empty() && !is_terminal(prod.symbols.front()) && visited.set(prod.symbols.front())){
+                        stack.push_back(prod.symbols.front());
+                    }
+                }
+            }
+            std::sort(s.closure.begin(), s.closure.end(), [&](item_id x, item_id y){ return item_less(x, y); });
+        }
+
+        // same ordering as item_comparetor.
+        bool item_less(item_id x, item_id y) const{
+            production const &px = item_to_production(x), &py = item_to_production(y);
+            if(px.lhs_symbol != py.lhs_symbol){
+                return px.lhs_symbol < py.lhs_symbol;
+            }
+            std::size_t xpos = x - px.first_item, ypos = y - py.first_item;
+            if(xpos != ypos){
+                return xpos < ypos;
+            }
+            return item_production[x] < item_production[y];
+        }
+
+        // same ordering as items_comparetor.
+        bool state_less(std::size_t x, std::size_t y) const{
+            state const &sx = dense_states[x], &sy = dense_states[y];
+            for(std::size_t k = 0; k < sx.closure.size() && k < sy.closure.size(); ++k){
+                item_id i = sx.closure[k], j = sy.closure[k];
+                if(i != j){
+                    return item_less(i, j);
+                }
+                int r = lookahead[sx.lookahead_node[k]].compare(lookahead[sy.lookahead_node[k]]);
+                if(r != 0){
+                    return r < 0;
+                }
+            }
+            return sx.closure.size() < sy.closure.size();
+        }
+
+        // kernel items of each state and the (state, nonterminal) pairs of its
+        // closure get one lookahead node each, the start item gets start_node.
+        void make_lookahead_node(){
+            lookahead.clear();
+            kernel_node_base.assign(dense_states.size(), 0);
+            nonterminal_node.assign(dense_states.size(), std::vector<std::pair<symbol_id, std::size_t>>());
+            auto new_node = [&](){
+                lookahead.push_back(dynamic_bitset(terminals.size()));
+                return lookahead.size() - 1;
+            };
+            for(std::size_t n = 0; n < dense_states.size(); ++n){
+                state &s = dense_states[n];
+                kernel_node_base[n] = lookahead.size();
+                for(std::size_t k = 0; k < s.kernel.size(); ++k){
+                    new_node();
+                }
+                for(item_id i : s.closure){
+                    if(item_to_pos(i) == 0 && !(n == 0 && i == s.kernel.front())){
+                        symbol_id a = item_to_production(i).lhs_symbol;
+                        if(nonterminal_node[n].empty() || nonterminal_node[n].back().first != a){
+                            nonterminal_node[n].push_back(std::make_pair(a, new_node()));
+                        }
+                    }
+                }
+                std::sort(nonterminal_node[n].begin(), nonterminal_node[n].end());
+            }
+            for(std::size_t n = 0; n < dense_states.size(); ++n){
+                state &s = dense_states[n];
+                s.lookahead_node.resize(s.closure.size());
+                for(std::size_t k = 0; k < s.closure.size(); ++k){
+                    item_id i = s.closure[k];
+                    auto kter = std::lower_bound(s.kernel.begin(), s.kernel.end(), i);
+                    if(kter != s.kernel.end() && *kter == i){
+                        s.lookahead_node[k] = kernel_node_base[n] + (kter - s.kernel.begin());
+                    }else{
+                        s.lookahead_node[k] = find_nonterminal_node(n, item_to_production(i).lhs_symbol);
+                    }
+                }
+            }
+            start_node = kernel_node_base[0];
+        }
+
+        std::size_t find_kernel_node(std::size_t n, item_id i) const{
+            kernel_type const &k = dense_states[n].kernel;
+            return kernel_node_base[n] + (std::lower_bound(k.begin(), k.end(), i) - k.begin());
+        }
+
+        std::size_t find_nonterminal_node(std::size_t n, symbol_id a) const{
+            auto const &v = nonterminal_node[n];
+            return std::lower_bound(v.begin(), v.end(), std::make_pair(a, std::size_t(0)))->second;
+        }
+
+        void propagate(std::vector<std::vector<std::size_t>> const &edge){
+            std::vector<std::size_t> queue;
+            std::vector<bool> queued(lookahead.size(), false);
+            for(std::size_t n = 0; n < lookahead.size(); ++n){
+                if(!lookahead[n].none()){
+                    queue.push_back(n);
+                    queued[n] = true;
+                }
+            }
+            while(!queue.empty()){
+                std::size_t n = queue.back();
+                queue.pop_back();
+                queued[n] = false;
+                for(std::size_t m : edge[n]){
+                    if(lookahead[m].merge(lookahead[n]) && !queued[m]){
+                        queue.push_back(m);
+                        queued[m] = true;
+                    }
+                }
+            }
+        }
+
+        items materialize(std::size_t n) const{
+            state const &s = dense_states[n];
+            items r;
+            for(std::size_t k = 0; k < s.closure.size(); ++k){
+                production const &p = item_to_production(s.closure[k]);
+                item i;
+                i.lhs = p.lhs;
+                i.rhs = *p.rhs;
+                i.pos = item_to_pos(s.closure[k]);
+                lookahead[s.lookahead_node[k]].for_each([&](std::size_t t){
+                    i.lookahead.insert(i.lookahead.end(), terminals[t]);
+                });
+                r.base_type::insert(r.end(), std::move(i));
+            }
+            return r;
+        }
+
+        grammar const &g;
+        std::vector<term> const &terminals, &symbol_terms;
+        std::map<term, symbol_id> const &symbol_index;
+        dynamic_bitset const &nullable;
+        std::vector<dynamic_bitset> const &first;
+        std::vector<production> productions;
+        std::vector<std::vector<std::size_t>> symbol_productions;
+        std::vector<std::size_t> item_production;
+        std::size_t start_production = 0;
+        std::vector<dynamic_bitset> first_after;
+        dynamic_bitset nullable_after;
+        std::vector<state> dense_states;
+        std::vector<dynamic_bitset> lookahead;
+        std::vector<std::size_t> kernel_node_base;
+        std::vector<std::vector<std::pair<symbol_id, std::size_t>>> nonterminal_node;
+        std::size_t start_node = 0;
+    };
+
     static std::ostream &out_term_set(std::ostream &os, term_set const &s){
         for(auto iter = s.begin(); iter != s.end(); ++iter){
             os << *iter;
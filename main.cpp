@@ -2,16 +2,34 @@
 #include "automaton_lexer.hpp"
 
 int main(int argc, char *argv[]){
-    if(argc != 2 && argc != 3){
-        std::cout << "usage: lxq ifile [ofiles_directry]" << std::endl;
+    scanner::scan_options options;
+    std::vector<std::string> args;
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg.compare(0, 2, "--") != 0){
+            args.push_back(arg);
+        }else if(!options.parse(arg)){
+            scanner::scan_options::usage(std::cout);
+            return 0;
+        }
+    }
+
+    if(!options.resolve()){
+        std::cout << "--lalr-lookahead=deremer-pennello needs --lalr-builder=dense." << std::endl;
+        scanner::scan_options::usage(std::cout);
+        return 0;
+    }
+
+    if(args.size() != 1 && args.size() != 2){
+        scanner::scan_options::usage(std::cout);
         return 0;
     }
 
     std::string place;
-    if(argc == 3){
-        place = argv[2];
+    if(args.size() == 2){
+        place = args[1];
     }
 
-    scanner::scan(argv[1], place);
+    scanner::scan(args[0], place, options);
     return 0;
 }
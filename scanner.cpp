@@ -70,7 +70,7 @@ namespace scanner{
         lex.new_regex("\\)", r_round_paren);
         lex.new_regex("\\|", vertical_bar);
         lex.new_regex("=", equal);
-        lex.new_regex("_\".*\"_", string);
+        lex.new_regex("_\".*?\"_", string);
         lex.new_regex("[a-zA-Z_][a-zA-Z0-9_]*", identifier);
     }
 
@@ -160,6 +160,14 @@ namespace scanner{
         }
     }
 
+    ast const *scanning_data_type::get_value_type_opt(ast const *ptr){
+        if(ptr->token.value.empty()){
+            return ast::dummy_storage_ptr();
+        }else{
+            return ptr->nodes[1];
+        }
+    }
+
     void scanning_data_type::check_recover_rhs_seq(rhs_seq const &seq){
         bool has_error_token = false;
         for(auto iter = seq.begin(); iter != seq.end(); ++iter){
@@ -268,11 +276,16 @@ namespace scanner{
 
     void scanning_data_type::get_expr(ast const *ptr){
         rhs_seq_set s;
-        ordered_lhs.push_back(ptr->nodes[0]->token);
+        ordered_lhs.push_back(ptr->nodes[0]->nodes[0]->token);
         get_rhs(ptr->nodes[2], s);
         auto p = rules.insert(std::make_pair(ptr->nodes[0]->nodes[0]->token, s));
         if(!p.second){
             expr_statements_error.push_back(scanning_exception("duplicated rule", ptr->nodes[0]->token.char_num, ptr->nodes[0]->token.word_num, ptr->nodes[0]->token.line_num));
+            return;
+        }
+        ast const *value_type = get_value_type_opt(ptr->nodes[0]->nodes[1]);
+        if(!value_type->token.value.empty()){
+            lhs_value_type_map.insert(std::make_pair(ptr->nodes[0]->nodes[0]->token, value_type->token));
         }
     }
 
@@ -350,17 +363,20 @@ namespace scanner{
     }
 
     void scanning_data_type::get_identifier_seq(ast const *ptr, linkdir dir){
-        ast const *identifier;
-        if(ptr->nodes.size() == 3){
+        ast const *identifier, *value_type;
+        if(ptr->nodes.size() == 4){
             get_identifier_seq(ptr->nodes[0], dir);
             identifier = ptr->nodes[2];
+            value_type = get_value_type_opt(ptr->nodes[3]);
         }else{
             identifier = ptr->nodes[0];
+            value_type = get_value_type_opt(ptr->nodes[1]);
         }
         check_reserved_token(identifier->token);
         symbol_data_type symbol_data;
         symbol_data.priority = current_token_priority;
         symbol_data.dir = dir;
+        symbol_data.value_type = value_type->token;
         std::pair<symbol_data_map_type::const_iterator, bool> p = symbol_data_map.insert(std::make_pair(identifier->token, symbol_data));
         if(!p.second){
             identifier_seq_error.push_back(scanning_exception("token.", identifier->token.char_num, identifier->token.word_num, identifier->token.line_num));
@@ -403,6 +419,11 @@ namespace scanner{
 
     void scanning_data_type::collect_info(){
         get_regexp_statements(regexp_body);
+        get_top_level_seq_statements(token_body);
+        if(identifier_seq_error.size() > 0){
+            throw(identifier_seq_error);
+        }
+
         std::map<std::size_t, std::pair<const token_type, regexp_symbol_data_type> const*> sorted_regexp_map;
         for(auto &iter : regexp_symbol_data_map){
             sorted_regexp_map.insert(std::make_pair(iter.second.priority, &iter));
@@ -410,11 +431,14 @@ namespace scanner{
         scanning_exception_seq exception_seq;
         for(auto &iter : sorted_regexp_map){
             try{
+                // typed tokens get their value from the parser at shift.
                 std::string str = iter.second->second.regexp.to_str();
+                auto symbol_iter = symbol_data_map.find(iter.second->first);
+                bool typed = symbol_iter != symbol_data_map.end() && !symbol_iter->second.value_type.value.empty() && iter.second->second.action && iter.second->second.action->token.value.to_str() != "drop";
                 automaton_lexer.add_rule(
                     str.substr(2, str.size() - 4),
                     iter.second->first.value.to_str(),
-                    iter.second->second.action
+                    iter.second->second.action && !typed
                         ? iter.second->second.action->token.value.to_str()
                         : ""
                 );
@@ -426,11 +450,6 @@ namespace scanner{
             throw exception_seq;
         }
 
-        get_top_level_seq_statements(token_body);
-        if(identifier_seq_error.size() > 0){
-            throw(identifier_seq_error);
-        }
-
         lalr_generator_type::item s;
         static vstring s_prime = { 'S', '\'' };
         s.lhs = lalr_generator.symbol_manager.set_nonterminal(vstring_range(s_prime.begin(), s_prime.end()));
@@ -556,7 +575,11 @@ namespace scanner{
                         if(symbol.arg.value.empty()){
                             continue;
                         }
-                        if(lalr_generator_type::is_terminal_symbol_functor()(lalr_generator.symbol_manager.get(symbol.identifier.value), rules)){
+                        if(has_value_types()){
+                            if(value_type_str(symbol.identifier).empty()){
+                                exception_seq.push_back(scanning_exception("'" + symbol.identifier.value.to_str() + "' has not value type.", iter.first.char_num, iter.first.word_num, iter.first.line_num));
+                            }
+                        }else if(lalr_generator_type::is_terminal_symbol_functor()(lalr_generator.symbol_manager.get(symbol.identifier.value), rules)){
                             if(translator_token_to_lexer_map.find(symbol.identifier.value.to_str())->second->action.empty()){
                                 exception_seq.push_back(scanning_exception("'" + symbol.identifier.value.to_str() + "' has not action.", iter.first.char_num, iter.first.word_num, iter.first.line_num));
                             }
@@ -565,6 +588,16 @@ namespace scanner{
                 }
             }
 
+            for(auto &iter : symbol_data_map){
+                if(iter.second.value_type.value.empty()){
+                    continue;
+                }
+                auto regexp_iter = regexp_symbol_data_map.find(iter.first);
+                if(regexp_iter == regexp_symbol_data_map.end() || !regexp_iter->second.action || regexp_iter->second.action->token.value.to_str() == "drop"){
+                    exception_seq.push_back(scanning_exception("'" + iter.first.value.to_str() + "' has not action.", iter.first.char_num, iter.first.word_num, iter.first.line_num));
+                }
+            }
+
             if(!exception_seq.empty()){
                 throw exception_seq;
             }
@@ -601,14 +634,25 @@ namespace scanner{
             }
         }
 
-        lalr_generator.lr0_kernel_items(lalr_generator.grammar, states_prime, states, first_state, terminal_symbol_set, s);
-        lalr_generator.make_goto_map(lalr_generator.grammar, terminal_symbol_set, states_prime, states, s);
-        lalr_generator.completion_lookahead(lalr_generator.grammar, states, first_state, s);
+        if(options.lalr_builder == scan_options::lalr_builder_type::dense){
+            lalr_generator_type::dense_builder builder(lalr_generator.grammar, lalr_generator.analysis(lalr_generator.grammar), s);
+            builder.make_lr0();
+            if(options.lalr_lookahead == scan_options::lalr_lookahead_type::deremer_pennello){
+                builder.make_lookahead_deremer_pennello();
+            }else{
+                builder.make_lookahead();
+            }
+            lalr_generator_make_result = builder.make(states, true, lalr_generator.symbol_data_map);
+        }else{
+            lalr_generator.lr0_kernel_items(lalr_generator.grammar, states_prime, states, first_state, terminal_symbol_set, s, options.jobs);
+            lalr_generator.make_goto_map(lalr_generator.grammar, terminal_symbol_set, states_prime, states, s, options.jobs);
+            lalr_generator.completion_lookahead(lalr_generator.grammar, states, first_state, s);
 
-        lalr_generator_type::items::iterator first_item;
-        states_prime.clear();
-        states = lalr_generator.c_closure(lalr_generator.grammar, states, first_state, first_item);
-        lalr_generator_make_result = lalr_generator.make2(lalr_generator.grammar, states, first_state, *first_item, lalr_generator.symbol_data_map);
+            lalr_generator_type::items::iterator first_item;
+            states_prime.clear();
+            states = lalr_generator.c_closure(lalr_generator.grammar, states, first_state, first_item);
+            lalr_generator_make_result = lalr_generator.make2(lalr_generator.grammar, states, first_state, *first_item, lalr_generator.symbol_data_map);
+        }
         if(lalr_generator_make_result.conflict_set.size() > 0){
             lalr_generator_type::exception_seq exception_seq;
             for(auto &i : lalr_generator_make_result.conflict_set){
@@ -650,6 +694,106 @@ namespace scanner{
         }
     }
 
+    // the narrowest unsigned type holding max.
+    static const char *generate_cpp_uint_type(std::size_t max){
+        if(max <= 0xff){
+            return "std::uint8_t";
+        }else if(max <= 0xffff){
+            return "std::uint16_t";
+        }else{
+            return "std::uint32_t";
+        }
+    }
+
+    static void generate_cpp_array(std::ostream &os, std::string const &indent, std::string const &name, std::vector<std::size_t> const &v){
+        std::size_t max = 0;
+        for(std::size_t n : v){
+            max = (std::max)(max, n);
+        }
+        os << indent << "static constexpr " << generate_cpp_uint_type(max) << " " << name << "[" << v.size() << "] = {\n";
+        for(std::size_t i = 0; i < v.size(); ++i){
+            os << (i % 16 == 0 ? indent + "    " : "") << v[i] << (i + 1 < v.size() ? "," : "") << ((i + 1) % 16 == 0 || i + 1 == v.size() ? "\n" : " ");
+        }
+        os << indent << "};\n";
+    }
+
+    // rows of (column, value) cells packed by row displacement, longest rows
+    // first. the cell at base[r] + column belongs to row r when check holds
+    // r + 1.
+    struct packed_rows{
+        std::vector<std::vector<std::pair<std::size_t, std::size_t>>> row;
+        std::vector<std::size_t> base, next, check;
+
+        packed_rows(std::size_t row_count) : row(row_count), base(row_count, 0){}
+
+        void pack(std::size_t column_count){
+            std::vector<std::size_t> order;
+            for(std::size_t r = 0; r < row.size(); ++r){
+                order.push_back(r);
+            }
+            std::stable_sort(order.begin(), order.end(), [&](std::size_t x, std::size_t y){ return row[x].size() > row[y].size(); });
+            next.assign(column_count, 0);
+            check.assign(column_count, 0);
+            for(std::size_t r : order){
+                if(row[r].empty()){
+                    continue;
+                }
+                std::size_t b = 0;
+                for(; ; ++b){
+                    bool fit = true;
+                    for(auto &cell : row[r]){
+                        if(b + cell.first < check.size() && check[b + cell.first] != 0){
+                            fit = false;
+                            break;
+                        }
+                    }
+                    if(fit){
+                        break;
+                    }
+                }
+                base[r] = b;
+                if(check.size() < b + column_count){
+                    next.resize(b + column_count, 0);
+                    check.resize(b + column_count, 0);
+                }
+                for(auto &cell : row[r]){
+                    next[b + cell.first] = cell.second;
+                    check[b + cell.first] = r + 1;
+                }
+            }
+        }
+    };
+
+    bool scanning_data_type::has_value_types() const{
+        if(!lhs_value_type_map.empty()){
+            return true;
+        }
+        for(auto &iter : symbol_data_map){
+            if(!iter.second.value_type.value.empty()){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::string scanning_data_type::value_type_str(token_type const &symbol) const{
+        vstring_range value_type;
+        auto symbol_iter = symbol_data_map.find(symbol);
+        if(symbol_iter != symbol_data_map.end()){
+            value_type = symbol_iter->second.value_type.value;
+        }else{
+            auto lhs_iter = lhs_value_type_map.find(symbol);
+            if(lhs_iter != lhs_value_type_map.end()){
+                value_type = lhs_iter->second.value;
+            }
+        }
+        if(value_type.empty()){
+            return "";
+        }
+        std::string str = value_type.to_str();
+        return str.substr(2, str.size() - 4);
+    }
+
     std::vector<vstring_range> make_signature(
         vstring_range const &semantic_action,
         vstring_range const &return_type,
@@ -666,6 +810,102 @@ namespace scanner{
         os << R"text(#ifndef LXQ_HPP_
 #define LXQ_HPP_
 
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#include <exception>
+#include <iterator>
+#include <utility>
+#endif
+
+namespace lxq{
+    // monotonic arena. data made by new(arena) are bump allocated from its
+    // blocks, and reset() frees them all at once. it counts the semantic
+    // values that own data in it, and refuses to reset while one is alive.
+    class arena{
+    public:
+        explicit arena(std::size_t block_size = 65536) : block_size(block_size){}
+        arena(const arena&) = delete;
+        arena &operator =(const arena&) = delete;
+
+        void *allocate(std::size_t n){
+            n = (n + alignment - 1) / alignment * alignment;
+            while(current < blocks.size() && used + n > blocks[current].size){
+                ++current;
+                used = 0;
+            }
+            if(current == blocks.size()){
+                std::size_t size = n > block_size ? n : block_size;
+                blocks.push_back(block{ std::unique_ptr<char[]>(new char[size]), size });
+                used = 0;
+            }
+            void *p = blocks[current].data.get() + used;
+            used += n;
+            return p;
+        }
+
+        bool owns(const void *p) const{
+            if(current < blocks.size() && inside(blocks[current], p)){
+                return true;
+            }
+            for(const block &b : blocks){
+                if(inside(b, p)){
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // kept up to date by value_ptr.
+        void retain(){
+            ++live;
+        }
+
+        void release(){
+            --live;
+        }
+
+        std::size_t live_values() const{
+            return live;
+        }
+
+        // keeps the blocks for the next parse.
+        void reset(){
+            if(live > 0){
+                throw std::runtime_error("arena : reset while semantic values are alive.");
+            }
+            current = 0;
+            used = 0;
+        }
+
+    private:
+        static const std::size_t alignment = alignof(std::max_align_t);
+
+        struct block{
+            std::unique_ptr<char[]> data;
+            std::size_t size;
+        };
+
+        static bool inside(const block &b, const void *p){
+            return p >= b.data.get() && p < b.data.get() + b.size;
+        }
+
+        std::size_t block_size, current = 0, used = 0, live = 0;
+        std::vector<block> blocks;
+    };
+}
+
+inline void *operator new(std::size_t n, lxq::arena &a){
+    return a.allocate(n);
+}
+
+inline void operator delete(void*, lxq::arena&) noexcept{}
+
 namespace lxq{
     template<class T = void>
     class semantic_data_proto{
@@ -674,344 +914,1185 @@ namespace lxq{
     };
 
     using semantic_data = semantic_data_proto<>;
-}
 
-#endif
-)text";
-    }
+    // deleter of the semantic values. a value inside an arena is only
+    // destroyed, its memory goes with the next reset of the arena.
+    struct value_deleter{
+        arena *owner = nullptr;
 
-    void scanning_data_type::generate_cpp(std::ostream &os){
-        std::string include_guard = grammar_namespace->token.value.to_str();
-        for(auto &c : include_guard){
-            if(std::islower(c)){
-                c = std::toupper(c);
+        void operator ()(semantic_data *p) const{
+            if(owner){
+                p->~semantic_data();
+                owner->release();
+            }else{
+                delete p;
             }
         }
-        os << "#ifndef " << include_guard << "_HPP_\n";
-        os << "#define " << include_guard << "_HPP_\n";
+    };
 
-        os << R"text(
-#include <functional>
-#include <exception>
-#include <sstream>
-#include <vector>
-#include <map>
-#include <cstdlib>
-#include <cassert>
-)text";
-        os << "\n";
-        os << "#include \"lxq.hpp\"\n";
-        os << "#include \"" << regexp_namespace->token.value.to_str() << ".hpp\"\n\n";
+    using value_ptr = std::unique_ptr<semantic_data, value_deleter>;
 
-        os << "namespace " << grammar_namespace->token.value.to_str() << "{";
-        os << R"text(
-    using semantic_data = lxq::semantic_data;
+    // allocation policies of the generated lexers and parsers. under heap
+    // the actions are called as they are and their values are deleted.
+    // under arena the actions get the arena as their first argument, and
+    // the values they make inside it are only destroyed.
+    struct heap{};
 
-    // parser
-    template<class Lexer, class SemanticDataProc>
-    class parser{
-    private:
-        using term = int;
-        using iterator = typename Lexer::iterator;
-        using token_type = typename Lexer::token_type;
-        using arg_type = std::vector<std::unique_ptr<semantic_data>>;
-        using call_function = std::function<std::unique_ptr<semantic_data>(parser&, arg_type const&)>;
+    template<class F>
+    auto apply(heap*, F f) -> decltype(f()){
+        return f();
+    }
 
-    public:
-        // parsing_error
-        class parsing_error : public std::runtime_error{
-        public:
-            parsing_error(iterator first, iterator last, std::size_t line_num, std::size_t char_num, std::size_t word_num) :
-                std::runtime_error("parsing error."),
-                first(first),
-                last(last),
-                line_num(line_num),
-                char_num(char_num),
-                word_num(word_num)
-            {}
+    template<class F>
+    auto apply(arena *a, F f) -> decltype(f(*a)){
+        return f(*a);
+    }
 
-            parsing_error(parsing_error const &other) :
-                std::runtime_error("parsing error."),
-                first(other.first),
-                last(other.last),
-                line_num(other.line_num),
-                char_num(other.char_num),
-                word_num(other.word_num)
-            {}
+    inline value_ptr own(heap*, semantic_data *p){
+        return value_ptr(p);
+    }
 
-            iterator first, last;
-            std::size_t line_num, char_num, word_num;
-        };
+    inline value_ptr own(arena *a, semantic_data *p){
+        if(p && a->owns(p)){
+            a->retain();
+            return value_ptr(p, value_deleter{ a });
+        }
+        return value_ptr(p);
+    }
 
-    private:
-        struct term_sequence_data{
-            std::size_t norm;
-            call_function call;
-        };
+    // the number of values alive in the allocator, none under heap.
+    inline std::size_t live_values(heap*){
+        return 0;
+    }
 
-        struct parsing_table_item{
-            enum class enum_action{
-                shift,
-                reduce,
-                accept
-            };
+    inline std::size_t live_values(arena *a){
+        return a->live_values();
+    }
 
-            enum_action action;
-            std::size_t num;
-        };
+    // resets the arena once no value from it is alive.
+    inline void recycle(heap*){}
 
-        struct parsing_data{
-            std::size_t first;
-            std::map<std::size_t, std::pair<term, term_sequence_data>> n2r;
-            std::map<std::size_t, std::map<term, parsing_table_item>> parsing_table;
-            std::map<std::size_t, std::map<term, std::size_t>> goto_table;
-        };
+    inline void recycle(arena *a){
+        if(a->live_values() == 0){
+            a->reset();
+        }
+    }
 
-        static parsing_data const &parsing_data_storage(){
-            auto init = [](){
-                return parsing_data{
-                    )text";
-        os << lalr_generator_make_result.first << ", // first";
+    // fixed capacity stack kept inline, the parser's stacks when it is
+    // given a StackSize. pushing onto a full one throws.
+    template<class T, std::size_t N>
+    class inline_stack{
+    public:
+        inline_stack() = default;
+        inline_stack(const inline_stack&) = delete;
+        inline_stack &operator =(const inline_stack&) = delete;
 
-        os << R"text(
-                    // n2r
-                    decltype(parsing_data::n2r){)text";
-        {
-            std::size_t iterate_count = 0;
-            for(auto &iter : lalr_generator_make_result.n2r){
-                if(iter.second.first == -1){
-                    continue;
-                }
-                os << R"text(
-                        std::make_pair(
-                            )text";
-                os << iter.first << ",";
-                os << R"text(
-                            std::make_pair()text";
-                if(iter.second.second->semantic_data.action.empty()){
-                    os << iter.second.first << ", term_sequence_data{ " << iter.second.second->size() << ", [](parser &p, arg_type const &arg){ return std::unique_ptr<lxq::semantic_data>(nullptr); } })";
-                }else{
-                    os << iter.second.first << ", term_sequence_data{ " << iter.second.second->size() << ", [](parser &p, arg_type const &arg){ return call_" << iter.second.second->semantic_data.action.to_str() << "(p";
-                    {
-                        auto *p = iter.second.second->semantic_data.arg_to_element;
-                        if(p){
-                            for(std::size_t i = 0; i < p->size(); ++i){
-                                os << ", arg[" << p->at(i)->display_pos << "]";
-                            }
-                        }
-                    }
-                    os << "); } })";
-                }
-                os << R"text(
-                        ))text";
-                if(iterate_count + 1 < lalr_generator_make_result.n2r.size()){
-                    os << ",";
-                }
-                ++iterate_count;
-            }
+        ~inline_stack(){
+            clear();
         }
-        os << R"text(
-                    },
 
-                    // parsing_table
-                    decltype(parsing_data::parsing_table){)text";
-        {
-            std::size_t iterate_count = 0;
-            for(auto &iter : lalr_generator_make_result.parsing_table){
-                os << R"text(
-                        std::make_pair(
-                            )text";
-                os << iter.first << ",";
-                os << R"text(
-                            std::map<term, parsing_table_item>{)text";
-                {
-                    std::size_t iterate_count = 0;
-                    for(auto &jter : iter.second){
-                        os << R"text(
-                                std::make_pair()text";
-                        os << jter.first << ", parsing_table_item{ ";
-                        switch(jter.second.action){
-                        case lalr_generator_type::lr_parsing_table_item::enum_action::shift:
-                            os << "parsing_table_item::enum_action::shift";
-                            break;
+        void push_back(T &&v){
+            emplace_back(std::move(v));
+        }
 
-                        case lalr_generator_type::lr_parsing_table_item::enum_action::reduce:
-                            os << "parsing_table_item::enum_action::reduce";
-                            break;
+        void push_back(const T &v){
+            emplace_back(v);
+        }
 
-                        case lalr_generator_type::lr_parsing_table_item::enum_action::accept:
-                            os << "parsing_table_item::enum_action::accept";
-                            break;
-                        }
-                        os << ", " << jter.second.num << " })";
-                        if(iterate_count + 1 != iter.second.size()){
-                            os << ",";
-                        }
-                        ++iterate_count;
-                    }
-                }
-                os << R"text(
-                            }
-                        ))text";
-                if(iterate_count + 1 != lalr_generator_make_result.parsing_table.size()){
-                    os << ",";
-                }
-                ++iterate_count;
+        template<class... Args>
+        void emplace_back(Args&&... args){
+            if(count == N){
+                throw std::runtime_error("parser stack overflow.");
             }
+            new(data() + count) T(std::forward<Args>(args)...);
+            ++count;
         }
-        os << R"text(
-                    },
 
-                    // goto_table
-                    decltype(parsing_data::goto_table){)text";
-        {
-            std::size_t iterate_count = 0;
-            for(auto &iter : lalr_generator_make_result.goto_table){
-                os << R"text(
-                        std::make_pair(
-                            )text";
-                os << iter.first << ",";
-                os << R"text(
-                            std::map<term, std::size_t>{)text";
-                {
-                    std::size_t iterate_count = 0;
-                    for(auto &jter : iter.second){
-                        os << R"text(
-                                )text";
-                        os << "std::make_pair(" << jter.first << ", " << jter.second << ")";
-                        if(iterate_count + 1 != iter.second.size()){
-                            os << ",\n";
-                        }
-                        ++iterate_count;
-                    }
-                }
-                if(iter.second.empty()){
-                    os << R"text(}
-                        ))text";
-                }else{
-                    os << R"text(
-                            }
-                        ))text";
-                }
-                if(iterate_count + 1 != lalr_generator_make_result.goto_table.size()){
-                    os << ",";
-                }
-                ++iterate_count;
+        void pop_back(){
+            data()[--count].~T();
+        }
+
+        // only shrinks.
+        void resize(std::size_t n){
+            while(count > n){
+                pop_back();
             }
         }
-        os << R"text(
-                    }
-                };
-            };
-            static parsing_data data = init();
-            return data;
+
+        void clear(){
+            resize(0);
         }
 
-)text";
-        std::set<vstring_range> generated_callfn;
-        for(auto &iter : lalr_generator_make_result.n2r){
-            if(
-                iter.second.first == -1 ||
-                generated_callfn.find(iter.second.second->semantic_data.action) != generated_callfn.end() ||
-                iter.second.second->semantic_data.action.empty()
-            ){
-                continue;
-            }
-            generated_callfn.insert(iter.second.second->semantic_data.action);
-            auto *p = iter.second.second->semantic_data.arg_to_element;
-            os << "        static std::unique_ptr<semantic_data> call_" << iter.second.second->semantic_data.action.to_str() << "(parser &p";
-            if(p){
-                for(std::size_t i = 0; i < p->size(); ++i){
-                    os << ", std::unique_ptr<semantic_data> const &v_" << i;
-                }
-            }
-            os << "){";
-            os << R"text(
-            return std::move(std::unique_ptr<semantic_data>(p.semantic_data_proc.)text";
-            os << iter.second.second->semantic_data.action.to_str() << "(";
-            if(p){
-                for(std::size_t i = 0; i < p->size(); ++i){
-                    os << "v_" << i;
-                    if(i + 1 != p->size()){
-                        os << ".get(), ";
-                    }else{
-                        os << ".get()";
-                    }
-                }
-            }
-            os << ")));";
-            os << R"text(
+        T *data(){
+            return reinterpret_cast<T*>(storage);
         }
 
-)text";
+        T &front(){
+            return data()[0];
         }
-        os << R"text(    public:
-        SemanticDataProc &semantic_data_proc;
 
-        parser() = delete;
-        parser(SemanticDataProc &semantic_data_proc) : semantic_data_proc(semantic_data_proc){}
+        T &back(){
+            return data()[count - 1];
+        }
 
-        template<class InputIter>
-        InputIter parse(std::unique_ptr<semantic_data> &value, InputIter first, InputIter last){
-            parsing_data const &table = parsing_data_storage();
-            std::vector<std::size_t> state_stack;
-            std::vector<std::unique_ptr<semantic_data>> value_stack;
-            state_stack.push_back(table.first);
-            while(true){
-                token_type &token = *first;
-                term const &t = static_cast<term>(token.identifier);
-                std::size_t s = state_stack.back();
-                auto const *table_second = &table.parsing_table.find(s)->second;
-                auto iter = table_second->find(t);
-                if(iter == table_second->end()){
-                    while(state_stack.size() > 1){
-                        table_second = &table.parsing_table.find(state_stack.back())->second;
-                        iter = table_second->find(static_cast<term>(lxq::token_id::error));
-                        if(iter == table_second->end() || iter->second.action != parsing_table_item::enum_action::shift){
-                            state_stack.pop_back();
-                            value_stack.pop_back();
+        std::size_t size() const{
+            return count;
+        }
+
+        bool empty() const{
+            return count == 0;
+        }
+
+    private:
+        alignas(T) unsigned char storage[N * sizeof(T)];
+        std::size_t count = 0;
+    };
+
+#if defined(__cpp_impl_coroutine)
+    // lazy generator of the coroutine flavour. the lexer yields its tokens
+    // through it, an exception thrown by the body comes out of begin() or
+    // operator ++.
+    template<class T>
+    class generator{
+    public:
+        struct promise_type{
+            T *value = nullptr;
+            std::exception_ptr exception;
+
+            generator get_return_object(){
+                return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept{ return {}; }
+            std::suspend_always final_suspend() noexcept{ return {}; }
+
+            std::suspend_always yield_value(T &v) noexcept{
+                value = std::addressof(v);
+                return {};
+            }
+
+            std::suspend_always yield_value(T &&v) noexcept{
+                value = std::addressof(v);
+                return {};
+            }
+
+            void return_void() noexcept{}
+
+            void unhandled_exception(){
+                exception = std::current_exception();
+            }
+        };
+
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        class iterator{
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+            iterator() = default;
+            explicit iterator(handle_type handle) : handle(handle){}
+
+            T &operator *() const{
+                return *handle.promise().value;
+            }
+
+            T *operator ->() const{
+                return handle.promise().value;
+            }
+
+            iterator &operator ++(){
+                generator::advance(handle);
+                return *this;
+            }
+
+            void operator ++(int){
+                ++*this;
+            }
+
+            bool operator ==(const iterator &other) const{
+                return done() == other.done();
+            }
+
+            bool operator !=(const iterator &other) const{
+                return done() != other.done();
+            }
+
+        private:
+            bool done() const{
+                return !handle || handle.done();
+            }
+
+            handle_type handle;
+        };
+
+        generator(generator &&other) noexcept : handle(std::exchange(other.handle, nullptr)){}
+        generator &operator =(generator &&other) noexcept{
+            std::swap(handle, other.handle);
+            return *this;
+        }
+
+        ~generator(){
+            if(handle){
+                handle.destroy();
+            }
+        }
+
+        iterator begin(){
+            advance(handle);
+            return iterator(handle);
+        }
+
+        iterator end(){
+            return iterator();
+        }
+
+    private:
+        explicit generator(handle_type handle) : handle(handle){}
+
+        static void advance(handle_type handle){
+            handle.resume();
+            if(handle.promise().exception){
+                std::rethrow_exception(std::exchange(handle.promise().exception, nullptr));
+            }
+        }
+
+        handle_type handle;
+    };
+
+    // lazy task of the coroutine flavour. co_await runs it and resumes the
+    // awaiting coroutine with its result. a top level task is run by
+    // start() up to its first suspension, and result() is read once done().
+    template<class T>
+    class task{
+    public:
+        struct promise_type{
+            T value{};
+            std::exception_ptr exception;
+            std::coroutine_handle<> continuation;
+
+            struct final_awaiter{
+                bool await_ready() noexcept{ return false; }
+
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept{
+                    if(handle.promise().continuation){
+                        return handle.promise().continuation;
+                    }
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() noexcept{}
+            };
+
+            task get_return_object(){
+                return task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept{ return {}; }
+            final_awaiter final_suspend() noexcept{ return {}; }
+
+            void return_value(T v){
+                value = std::move(v);
+            }
+
+            void unhandled_exception(){
+                exception = std::current_exception();
+            }
+        };
+
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        task(task &&other) noexcept : handle(std::exchange(other.handle, nullptr)){}
+        task &operator =(task &&other) noexcept{
+            std::swap(handle, other.handle);
+            return *this;
+        }
+
+        ~task(){
+            if(handle){
+                handle.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept{
+            return false;
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept{
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume(){
+            return result();
+        }
+
+        void start(){
+            handle.resume();
+        }
+
+        bool done() const{
+            return handle.done();
+        }
+
+        T result(){
+            if(handle.promise().exception){
+                std::rethrow_exception(handle.promise().exception);
+            }
+            return std::move(handle.promise().value);
+        }
+
+    private:
+        explicit task(handle_type handle) : handle(handle){}
+
+        handle_type handle;
+    };
+#endif
+}
+
+#endif
+)text";
+    }
+
+    void scanning_data_type::generate_cpp(std::ostream &os){
+        std::string include_guard = grammar_namespace->token.value.to_str();
+        for(auto &c : include_guard){
+            if(std::islower(c)){
+                c = std::toupper(c);
+            }
+        }
+        os << "#ifndef " << include_guard << "_HPP_\n";
+        os << "#define " << include_guard << "_HPP_\n";
+
+        // typed symbols share one alternative per distinct value type.
+        bool typed = has_value_types();
+        std::vector<std::string> value_types;
+        std::map<std::string, std::size_t> value_type_index;
+        auto add_value_type = [&](token_type const &symbol){
+            std::string str = value_type_str(symbol);
+            if(!str.empty() && value_type_index.insert(std::make_pair(str, value_types.size())).second){
+                value_types.push_back(str);
+            }
+        };
+        for(auto &iter : ordered_token_iters){
+            add_value_type(iter->first);
+        }
+        for(auto &lhs : ordered_lhs){
+            add_value_type(lhs);
+        }
+        auto value_member = [&](vstring_range const &symbol){
+            token_type token;
+            token.value = symbol;
+            std::string str = value_type_str(token);
+            return str.empty() ? std::string() : "v_" + std::to_string(value_type_index[str]);
+        };
+
+        // the statement running the action of production on arg into v,
+        // empty when the production leaves no value.
+        auto reduce_statement = [&](std::size_t production) -> std::string{
+            auto const &rule = *lalr_generator_make_result.n2r.find(production);
+            if(rule.second.first == -1){
+                return "";
+            }
+            std::string action = rule.second.second->semantic_data.action.to_str();
+            std::string lhs_index, set;
+            if(typed){
+                // a typed lhs without action gets a value initialized value.
+                std::string lhs_member = value_member(lalr_generator.symbol_manager.to_str(rule.second.first));
+                if(!lhs_member.empty()){
+                    lhs_index = lhs_member.substr(2);
+                    set = "v.set_" + lhs_index + "(";
+                }
+                if(action.empty() && set.empty()){
+                    return "";
+                }
+            }else if(action.empty()){
+                return "";
+            }else{
+                set = "v = lxq::own(allocator, ";
+            }
+            std::string str = set;
+            if(action.empty()){
+                str += "value_type_" + lhs_index + "()";
+            }else{
+                str += "lxq::apply(allocator, [&](auto &...alloc){ return semantic_data_proc." + action + "(alloc...";
+                auto *p = rule.second.second->semantic_data.arg_to_element;
+                if(p){
+                    for(std::size_t i = 0; i < p->size(); ++i){
+                        str += ", ";
+                        if(typed){
+                            str += "std::move(arg[" + std::to_string(p->at(i)->display_pos) + "]." + value_member(p->at(i)->identifier.value) + ")";
+                        }else{
+                            str += "arg[" + std::to_string(p->at(i)->display_pos) + "].get()";
+                        }
+                    }
+                }
+                str += "); })";
+            }
+            return str + (set.empty() ? ";" : ");");
+        };
+
+        os << R"text(
+#include <functional>
+#include <exception>
+#include <sstream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <iterator>
+#include <utility>
+#include <algorithm>
+#include <exception>
+#include <atomic>
+#include <thread>
+#include <type_traits>
+#include <cstdint>
+#include <cstdlib>
+#include <cassert>
+)text";
+        if(typed){
+            os << "#include <new>\n";
+        }
+        os << "\n";
+        os << "#include \"lxq.hpp\"\n";
+        os << "#include \"" << regexp_namespace->token.value.to_str() << ".hpp\"\n\n";
+
+        os << "namespace " << grammar_namespace->token.value.to_str() << "{";
+        os << R"text(
+    using semantic_data = lxq::semantic_data;
+
+    // parser. with a StackSize its stacks are kept inline with that
+    // capacity and it never allocates them, otherwise they are vectors.
+    // Allocator is the allocation policy of the semantic values, lxq::heap
+    // or lxq::arena. under the arena policy the actions get the arena as
+    // their first argument, and reset() resets it once no value from it is
+    // alive anymore.
+    template<class Lexer, class SemanticDataProc, std::size_t StackSize = 0, class Allocator = lxq::heap>
+    class parser{
+    private:
+        using term = int;
+        using iterator = typename Lexer::iterator;
+        using token_type = typename Lexer::token_type;
+)text";
+        if(typed){
+            os << "\n        // declared value types.\n";
+            for(std::size_t i = 0; i < value_types.size(); ++i){
+                os << "        using value_type_" << i << " = " << value_types[i] << ";\n";
+            }
+            os << R"text(
+        // semantic values, a tagged union over the declared value types.
+        class value_type{
+        public:
+            value_type(){}
+
+            value_type(value_type &&other){
+                *this = std::move(other);
+            }
+
+            value_type &operator =(value_type &&other){
+                if(this != &other){
+                    clear();
+                    switch(other.index){)text";
+            for(std::size_t i = 0; i < value_types.size(); ++i){
+                os << "\n                    case " << i + 1 << ":";
+                os << "\n                        set_" << i << "(std::move(other.v_" << i << "));";
+                os << "\n                        break;\n";
+            }
+            os << R"text(
+                    default:
+                        break;
+                    }
+                    other.clear();
+                }
+                return *this;
+            }
+
+            ~value_type(){
+                clear();
+            }
+
+            void clear(){
+                switch(index){)text";
+            for(std::size_t i = 0; i < value_types.size(); ++i){
+                os << "\n                case " << i + 1 << ":";
+                os << "\n                    destroy(v_" << i << ");";
+                os << "\n                    break;\n";
+            }
+            os << R"text(
+                default:
+                    break;
+                }
+                index = 0;
+            }
+)text";
+            for(std::size_t i = 0; i < value_types.size(); ++i){
+                os << "\n            template<class T>";
+                os << "\n            void set_" << i << "(T &&x){";
+                os << "\n                clear();";
+                os << "\n                new(&v_" << i << ") value_type_" << i << "(std::forward<T>(x));";
+                os << "\n                index = " << i + 1 << ";";
+                os << "\n            }\n";
+            }
+            os << R"text(
+            // 0 is no value, i + 1 is v_i.
+            std::size_t index = 0;
+            union{)text";
+            for(std::size_t i = 0; i < value_types.size(); ++i){
+                os << "\n                value_type_" << i << " v_" << i << ";";
+            }
+            os << R"text(
+            };
+
+        private:
+            template<class T>
+            static void destroy(T &x){
+                x.~T();
+            }
+        };
+)text";
+        }
+        os << R"text(
+    public:
+        // parsing_error
+        class parsing_error : public std::runtime_error{
+        public:
+            parsing_error(iterator first, iterator last, std::size_t line_num, std::size_t char_num, std::size_t word_num) :
+                std::runtime_error("parsing error."),
+                first(first),
+                last(last),
+                line_num(line_num),
+                char_num(char_num),
+                word_num(word_num)
+            {}
+
+            parsing_error(parsing_error const &other) :
+                std::runtime_error("parsing error."),
+                first(other.first),
+                last(other.last),
+                line_num(other.line_num),
+                char_num(other.char_num),
+                word_num(other.word_num)
+            {}
+
+            iterator first, last;
+            std::size_t line_num, char_num, word_num;
+        };
+
+    private:
+)text";
+        bool goto_backend = options.parser_backend == scan_options::parser_backend_type::goto_switch;
+        if(!goto_backend){
+            os << R"text(        // parsing tables. rows are packed by row displacement and a cell
+        // belongs to the state whose number + 1 is in check. actions are
+        // kind + 4 * num, kind 0 is error, 1 shift, 2 reduce and 3 accept.
+        enum{
+            action_error = 0,
+            action_shift = 1,
+            action_reduce = 2,
+            action_accept = 3
+        };
+
+)text";
+            using enum_action = lalr_generator_type::lr_parsing_table_item::enum_action;
+            std::size_t terminal_count = ordered_token_iters.size();
+            auto terminal_column = [&](term_type t) -> std::size_t{
+                return t == error_token_functor()() ? terminal_count + 1 : t == eos_functor()() ? terminal_count + 2 : static_cast<std::size_t>(t);
+            };
+            auto nonterminal_column = [](term_type t) -> std::size_t{
+                return static_cast<std::size_t>(-t - 2);
+            };
+
+            std::size_t state_count = 0, production_count = 0, nonterminal_count = 0;
+            for(auto &iter : lalr_generator_make_result.parsing_table){
+                state_count = (std::max)(state_count, iter.first + 1);
+            }
+            for(auto &iter : lalr_generator_make_result.goto_table){
+                state_count = (std::max)(state_count, iter.first + 1);
+            }
+            for(auto &iter : lalr_generator_make_result.n2r){
+                production_count = (std::max)(production_count, iter.first + 1);
+                if(iter.second.first != -1){
+                    nonterminal_count = (std::max)(nonterminal_count, nonterminal_column(iter.second.first) + 1);
+                }
+            }
+
+            packed_rows action_rows(state_count), goto_rows(state_count);
+            for(auto &iter : lalr_generator_make_result.parsing_table){
+                for(auto &jter : iter.second){
+                    std::size_t kind = jter.second.action == enum_action::shift ? 1 : jter.second.action == enum_action::reduce ? 2 : 3;
+                    action_rows.row[iter.first].push_back(std::make_pair(terminal_column(jter.first), kind + 4 * jter.second.num));
+                }
+            }
+            for(auto &iter : lalr_generator_make_result.goto_table){
+                for(auto &jter : iter.second){
+                    goto_rows.row[iter.first].push_back(std::make_pair(nonterminal_column(jter.first), jter.second));
+                }
+            }
+            action_rows.pack(terminal_count + 3);
+            goto_rows.pack(nonterminal_count);
+
+            std::vector<std::size_t> production_norm(production_count, 0), production_lhs(production_count, 0);
+            for(auto &iter : lalr_generator_make_result.n2r){
+                if(iter.second.first == -1){
+                    continue;
+                }
+                production_norm[iter.first] = iter.second.second->size();
+                production_lhs[iter.first] = nonterminal_column(iter.second.first);
+            }
+
+            os << "        // terminals keep their ids, error and end follow them.\n";
+            os << "        static std::size_t terminal_column(term t){\n";
+            os << "            return t == static_cast<term>(lxq::token_id::error) ? " << terminal_count + 1 << " : t == static_cast<term>(lxq::token_id::end) ? " << terminal_count + 2 << " : static_cast<std::size_t>(t);\n";
+            os << "        }\n\n";
+
+            os << "        static std::size_t action(std::size_t state, term t){\n";
+            generate_cpp_array(os, "            ", "base", action_rows.base);
+            generate_cpp_array(os, "            ", "next", action_rows.next);
+            generate_cpp_array(os, "            ", "check", action_rows.check);
+            os << "            std::size_t i = base[state] + terminal_column(t);\n";
+            os << "            return check[i] == state + 1 ? next[i] : static_cast<std::size_t>(action_error);\n";
+            os << "        }\n\n";
+
+            os << "        // the state reached from state by the lhs of production.\n";
+            os << "        static std::size_t goto_state(std::size_t state, std::size_t production){\n";
+            generate_cpp_array(os, "            ", "lhs", production_lhs);
+            generate_cpp_array(os, "            ", "base", goto_rows.base);
+            generate_cpp_array(os, "            ", "next", goto_rows.next);
+            os << "            return next[base[state] + lhs[production]];\n";
+            os << "        }\n\n";
+
+            os << "        static std::size_t norm(std::size_t production){\n";
+            generate_cpp_array(os, "            ", "length", production_norm);
+            os << "            return length[production];\n";
+            os << "        }\n\n";
+
+        }
+        if(typed){
+            os << R"text(        static value_type shift_value(parser &p, term t, token_type &token){
+            value_type v;
+            switch(t){)text";
+            for(auto &iter : ordered_token_iters){
+                std::string member = value_member(iter->first.value);
+                if(member.empty()){
+                    continue;
+                }
+                os << "\n            case " << lalr_generator.symbol_manager.get(iter->first.value) << ":";
+                os << "\n                v.set_" << member.substr(2) << "(lxq::apply(p.allocator, [&](auto &...alloc){ return p.semantic_data_proc." << regexp_symbol_data_map.find(iter->first)->second.action->token.value.to_str() << "(alloc..., token.first, token.last); }));";
+                os << "\n                break;\n";
+            }
+            os << R"text(
+            default:
+                break;
+            }
+            return v;
+        }
+
+)text";
+        }
+        if(goto_backend){
+            // the states recovery stops at.
+            os << "        static bool shifts_error(std::size_t state){\n";
+            os << "            switch(state){";
+            bool any = false;
+            for(auto &iter : lalr_generator_make_result.parsing_table){
+                auto jter = iter.second.find(error_token_functor()());
+                if(jter != iter.second.end() && jter->second.action == lalr_generator_type::lr_parsing_table_item::enum_action::shift){
+                    os << "\n            case " << iter.first << ":";
+                    any = true;
+                }
+            }
+            if(any){
+                os << "\n                return true;\n";
+            }
+            os << R"text(
+            default:
+                return false;
+            }
+        }
+
+)text";
+        }else{
+            // one case per production with an action, run on the top values.
+            std::string value = typed ? "value_type" : "lxq::value_ptr";
+            os << "        " << value << " reduce(std::size_t production, " << value << " *arg){\n";
+            os << "            " << value << " v;\n";
+            os << "            switch(production){";
+            for(auto &iter : lalr_generator_make_result.n2r){
+                std::string statement = reduce_statement(iter.first);
+                if(!statement.empty()){
+                    os << "\n            case " << iter.first << ":\n";
+                    os << "                " << statement << "\n";
+                    os << "                break;\n";
+                }
+            }
+            os << R"text(
+            default:
+                break;
+            }
+            return v;
+        }
+
+)text";
+        }
+        std::string value = typed ? "value_type" : "lxq::value_ptr";
+        std::string start_member = typed ? value_member(ordered_lhs.front().value) : "";
+        std::string result_type = !typed ? value : start_member.empty() ? "" : "value_type_" + start_member.substr(2);
+        std::string result = start_member.empty() ? ".front())" : ".front()." + start_member + ")";
+        std::size_t first_state = lalr_generator_make_result.first;
+        os << R"text(    public:
+        SemanticDataProc &semantic_data_proc;
+
+        parser() = delete;
+        parser(SemanticDataProc &semantic_data_proc) : semantic_data_proc(semantic_data_proc), allocator(nullptr){
+            static_assert(std::is_same<Allocator, lxq::heap>::value, "the arena policy needs an arena.");
+            reset();
+        }
+
+        parser(SemanticDataProc &semantic_data_proc, Allocator &allocator) : semantic_data_proc(semantic_data_proc), allocator(&allocator){
+            reset();
+        }
+
+        template<class InputIter>
+)text";
+        if(result_type.empty()){
+            os << "        InputIter parse(InputIter first, InputIter last){\n";
+        }else{
+            os << "        InputIter parse(" << result_type << " &value, InputIter first, InputIter last){\n";
+        }
+        os << "            reset();\n";
+        os << "            run<false>(first);\n";
+        if(!result_type.empty()){
+            os << "            value = std::move(value_stack" << result << ";\n";
+        }
+        os << "            return first;\n";
+        os << "        }\n\n";
+
+        os << "        // push interface. post() takes the tokens one at a time, the end\n";
+        os << "        // token last, and returns true once the input is accepted. the\n";
+        os << "        // stacks are kept between posts, reset() starts the next input.\n";
+        os << "        // parse() runs on the same stacks, so their capacity is reused.\n";
+        os << "        void reset(){\n";
+        os << "            state_stack.clear();\n";
+        os << "            value_stack.clear();\n";
+        os << "            state_stack.push_back(" << first_state << ");\n";
+        os << "            lxq::recycle(allocator);\n";
+        os << "        }\n\n";
+        os << "        bool post(token_type &token){\n";
+        os << "            token_type *first = &token;\n";
+        os << "            return run<true>(first);\n";
+        os << "        }\n";
+        if(!result_type.empty()){
+            os << "\n        // the value of the accepted input.\n";
+            os << "        void accept(" << result_type << " &value){\n";
+            os << "            value = std::move(value_stack" << result << ";\n";
+            os << "        }\n";
+        }
+        os << R"text(
+        // parses the inputs [first, last) on up to jobs threads and returns
+        // work(parser, input) for each input, in input order. the inputs are
+        // handed out one at a time, so a thread that is done early takes the
+        // next one. each thread keeps its own parser, and so its stacks, for
+        // all its inputs. its SemanticDataProc is made by make_proc(allocator)
+        // over an Allocator of the thread. the parser is reset after each
+        // input, which drops the values of the input and then recycles the
+        // Allocator. an exception from make_proc or the parser of a thread
+        // is rethrown first, otherwise the first exception thrown by work,
+        // in input order. either is rethrown once all threads are done. the
+        // result of work only needs to be move constructible. it must not
+        // hold values of the Allocator, which is gone by the time the
+        // results are returned. when values are still alive after the reset,
+        // the result of that input is dropped and the input fails instead.
+        template<class RandomAccessIter, class MakeProc, class Work>
+        static auto parse_batch(RandomAccessIter first, RandomAccessIter last, std::size_t jobs, MakeProc make_proc, Work work)
+            -> std::vector<decltype(work(std::declval<parser&>(), *first))>
+        {
+            using result_type = decltype(work(std::declval<parser&>(), *first));
+            std::size_t n = static_cast<std::size_t>(last - first);
+            std::size_t thread_count = (std::max)(std::min(jobs, n), static_cast<std::size_t>(1));
+            std::vector<std::unique_ptr<result_type>> results(n);
+            std::vector<std::exception_ptr> errors(n), setup_errors(thread_count);
+            std::atomic<std::size_t> next(0);
+            auto worker = [&](std::size_t t){
+                try{
+                    Allocator allocator;
+                    SemanticDataProc proc = make_proc(allocator);
+                    parser p(proc, allocator);
+                    for(std::size_t i; (i = next++) < n; ){
+                        try{
+                            results[i].reset(new result_type(work(p, first[i])));
+                        }catch(...){
+                            errors[i] = std::current_exception();
+                        }
+                        p.reset();
+                        if(lxq::live_values(&allocator) != 0){
+                            results[i].reset();
+                            p.reset();
+                            if(!errors[i]){
+                                errors[i] = std::make_exception_ptr(std::runtime_error("parse_batch : values of the allocator are alive after an input."));
+                            }
+                        }
+                    }
+                }catch(...){
+                    setup_errors[t] = std::current_exception();
+                }
+            };
+            std::vector<std::thread> threads;
+            for(std::size_t t = 1; t < thread_count; ++t){
+                threads.emplace_back(worker, t);
+            }
+            worker(0);
+            for(std::thread &t : threads){
+                t.join();
+            }
+            for(std::exception_ptr &e : setup_errors){
+                if(e){
+                    std::rethrow_exception(e);
+                }
+            }
+            for(std::exception_ptr &e : errors){
+                if(e){
+                    std::rethrow_exception(e);
+                }
+            }
+            std::vector<result_type> values;
+            values.reserve(n);
+            for(std::unique_ptr<result_type> &r : results){
+                values.push_back(std::move(*r));
+            }
+            return values;
+        }
+)text";
+        os << R"text(
+#if defined(__cpp_impl_coroutine)
+        // coroutine flavour of the push interface. co_await source.next()
+        // gives the next chunk of the input as a pair of const char*, an
+        // empty chunk ends it. the chunks are lexed by Lexer::push_stream as
+        // they arrive and the task returns true once the input is accepted.
+        // Lexer must therefore be, or derive from, a generated lexer over
+        // const char*, as in
+)text" << "        //     struct Lexer : " << regexp_namespace->token.value.to_str() << "<const char*>{ using iterator = const char*; };\n" << R"text(        // an adapter with only iterator and token_type is not enough here.
+        // the task runs on the parser's own stacks, so each parse in flight
+        // needs its own parser object. do not start a second parse_async,
+        // or call parse(), post() or validate(), on a parser whose task has
+        // not finished.
+        template<class Source, class Action>
+        lxq::task<bool> parse_async(Source &source, Action &action){
+            typename Lexer::template push_stream<Action, Allocator> lexer(action, allocator);
+            bool accepted = false;
+            auto sink = [&](token_type &&token){
+                if(!accepted){
+                    accepted = post(token);
+                }
+            };
+            reset();
+            while(true){
+                auto chunk = co_await source.next();
+                if(chunk.first == chunk.second){
+                    break;
+                }
+                lexer.feed(chunk.first, chunk.second, sink);
+            }
+            lexer.finish(sink);
+            co_return accepted;
+        }
+#endif
+)text";
+        os << "\n    private:\n";
+        os << "        Allocator *allocator;\n\n";
+        os << "        template<class T>\n";
+        os << "        using stack = typename std::conditional<StackSize == 0, std::vector<T>, lxq::inline_stack<T, StackSize>>::type;\n\n";
+        os << "        stack<std::size_t> state_stack;\n";
+        os << "        stack<" << value << "> value_stack;\n\n";
+        os << "        // runs the parser from the state on top of state_stack. it returns\n";
+        os << "        // true on accept, and in push mode false once a token is shifted.\n";
+        os << "        template<bool Push, class InputIter>\n";
+        os << "        bool run(InputIter &first){";
+
+        std::string validate_head = R"text(
+    public:
+        // recognizer only. it runs on the states alone, without values,
+        // actions or error recovery, and returns last if the input is
+        // accepted, otherwise the first token it does not accept. it shares
+        // the state stack with post(), which needs a reset() after it.
+        template<class InputIter>
+        InputIter validate(InputIter first, InputIter last){
+            state_stack.clear();
+            state_stack.push_back()text" + std::to_string(first_state) + ");\n";
+        if(goto_backend){
+            // each state is a label with a switch on the lookahead, each
+            // production a label running its action, and each lhs a label
+            // switching on the uncovered state.
+            using enum_action = lalr_generator_type::lr_parsing_table_item::enum_action;
+            std::string error = "throw parsing_error((*first).first, (*first).last, (*first).line_num, (*first).char_num, (*first).word_num);";
+            auto term_str = [](term_type t) -> std::string{
+                if(t == error_token_functor()()){
+                    return "static_cast<term>(lxq::token_id::error)";
+                }else if(t == eos_functor()()){
+                    return "static_cast<term>(lxq::token_id::end)";
+                }
+                return std::to_string(t);
+            };
+            auto state_switch = [&](std::string const &indent, std::vector<std::pair<std::size_t, std::size_t>> const &cases){
+                for(std::size_t i = 0; i < cases.size(); ++i){
+                    os << indent << (i + 1 < cases.size() ? "case " + std::to_string(cases[i].first) + ":" : "default:") << "\n";
+                    if(cases[i].second != static_cast<std::size_t>(-1)){
+                        os << indent << "    state_stack.push_back(" << cases[i].second << ");\n";
+                        os << indent << "    goto state_" << cases[i].second << ";\n";
+                    }else{
+                        os << indent << "    goto state_" << cases[i].first << ";\n";
+                    }
+                    if(i + 1 < cases.size()){
+                        os << "\n";
+                    }
+                }
+            };
+
+            std::size_t state_count = 0;
+            for(auto &iter : lalr_generator_make_result.parsing_table){
+                state_count = (std::max)(state_count, iter.first + 1);
+            }
+            for(auto &iter : lalr_generator_make_result.goto_table){
+                state_count = (std::max)(state_count, iter.first + 1);
+            }
+
+            // the label machine of run(), or of validate() when values is
+            // false. validate() only keeps the states and stops at the first
+            // error.
+            auto goto_machine = [&](bool values){
+                os << "\n            term t = static_cast<term>((*first).identifier);\n";
+                if(values){
+                    os << "            goto dispatch;\n";
+                }else{
+                    os << "            goto state_" << first_state << ";\n";
+                }
+
+                for(std::size_t state = 0; state < state_count; ++state){
+                    os << "\n            state_" << state << ":;\n";
+                    os << "            switch(t){\n";
+                    auto iter = lalr_generator_make_result.parsing_table.find(state);
+                    if(iter != lalr_generator_make_result.parsing_table.end()){
+                        // terminals with the same action share a case.
+                        std::vector<std::pair<std::pair<enum_action, std::size_t>, std::vector<term_type>>> groups;
+                        for(auto &jter : iter->second){
+                            auto kind = std::make_pair(jter.second.action, jter.second.num);
+                            auto group = std::find_if(groups.begin(), groups.end(), [&](decltype(groups[0]) const &g){ return g.first == kind; });
+                            if(group == groups.end()){
+                                groups.push_back(std::make_pair(kind, std::vector<term_type>{ jter.first }));
+                            }else{
+                                group->second.push_back(jter.first);
+                            }
+                        }
+                        for(auto &group : groups){
+                            for(term_type t : group.second){
+                                os << "            case " << term_str(t) << ":\n";
+                            }
+                            if(group.first.first == enum_action::shift){
+                                os << "                state_stack.push_back(" << group.first.second << ");\n";
+                                if(values && typed){
+                                    os << "                value_stack.push_back(shift_value(*this, t, *first));\n";
+                                }else if(values){
+                                    os << "                value_stack.push_back(std::move((*first).value));\n";
+                                }
+                                os << "                ++first;\n";
+                                if(values){
+                                    os << "                if(Push){\n";
+                                    os << "                    return false;\n";
+                                    os << "                }\n";
+                                }
+                                os << "                t = static_cast<term>((*first).identifier);\n";
+                                os << "                goto state_" << group.first.second << ";\n\n";
+                            }else if(group.first.first == enum_action::reduce){
+                                os << "                goto reduce_" << group.first.second << ";\n\n";
+                            }else{
+                                os << "                goto accept;\n\n";
+                            }
+                        }
+                    }
+                    os << "            default:\n";
+                    os << "                goto error;\n";
+                    os << "            }\n";
+                }
+
+                std::set<term_type> used_lhs;
+                for(auto &iter : lalr_generator_make_result.n2r){
+                    if(iter.second.first == -1){
+                        continue;
+                    }
+                    std::size_t norm = iter.second.second->size();
+                    std::string statement = values ? reduce_statement(iter.first) : "";
+                    used_lhs.insert(iter.second.first);
+                    os << "\n            reduce_" << iter.first << ":;\n";
+                    if(values && statement.empty()){
+                        if(norm > 0){
+                            os << "            value_stack.resize(value_stack.size() - " << norm << ");\n";
+                        }
+                        os << "            value_stack.emplace_back();\n";
+                    }else if(values){
+                        os << "            {\n";
+                        if(statement.find("arg[") != std::string::npos){
+                            os << "                " << value << " *arg = value_stack.data() + (value_stack.size() - " << norm << ");\n";
+                        }
+                        os << "                " << value << " v;\n";
+                        os << "                " << statement << "\n";
+                        if(norm > 0){
+                            os << "                value_stack.resize(value_stack.size() - " << norm << ");\n";
+                        }
+                        os << "                value_stack.push_back(std::move(v));\n";
+                        os << "            }\n";
+                    }
+                    if(norm > 0){
+                        os << "            state_stack.resize(state_stack.size() - " << norm << ");\n";
+                    }
+                    if(values){
+                        os << "            t = static_cast<term>((*first).identifier);\n";
+                    }
+                    os << "            goto goto_" << -iter.second.first - 2 << ";\n";
+                }
+
+                for(term_type lhs : used_lhs){
+                    std::vector<std::pair<std::size_t, std::size_t>> cases;
+                    for(auto &iter : lalr_generator_make_result.goto_table){
+                        auto jter = iter.second.find(lhs);
+                        if(jter != iter.second.end()){
+                            cases.push_back(std::make_pair(iter.first, jter->second));
+                        }
+                    }
+                    os << "\n            goto_" << -lhs - 2 << ":;\n";
+                    os << "            switch(state_stack.back()){\n";
+                    state_switch("            ", cases);
+                    os << "            }\n";
+                }
+
+                os << "\n            accept:;\n";
+                if(!values){
+                    os << "            return state_stack.size() == 2 ? last : first;\n";
+                    os << "\n            error:;\n";
+                    os << "            return first;\n";
+                    return;
+                }
+                os << "            if(value_stack.size() != 1){\n";
+                os << "                " << error << "\n";
+                os << "            }\n";
+                os << "            ++first;\n";
+                os << "            return true;\n";
+
+                std::vector<std::pair<std::size_t, std::size_t>> cases;
+                for(std::size_t state = 0; state < state_count; ++state){
+                    cases.push_back(std::make_pair(state, static_cast<std::size_t>(-1)));
+                }
+                os << R"text(
+            // the error token takes the place of the bad token, so there is
+            // nothing to recover with at the end.
+            error:;
+            if(t == static_cast<term>(lxq::token_id::end) || t == static_cast<term>(lxq::token_id::error)){
+                )text" << error << R"text(
+            }
+            t = static_cast<term>(lxq::token_id::error);
+            while(state_stack.size() > 1 && !shifts_error(state_stack.back())){
+                state_stack.pop_back();
+                value_stack.pop_back();
+            }
+
+            dispatch:;
+            switch(state_stack.back()){
+)text";
+                state_switch("            ", cases);
+                os << "            }\n";
+            };
+
+            goto_machine(true);
+            os << "        }\n";
+            os << validate_head;
+            goto_machine(false);
+            os << R"text(        }
+    };
+}
+
+#endif
+)text";
+            return;
+        }
+        os << R"text(
+            while(true){
+                token_type &token = *first;
+                term t = static_cast<term>(token.identifier);
+                std::size_t a = action(state_stack.back(), t);
+                if(a == action_error){
+                    // the error token takes the place of the bad token, so
+                    // there is nothing to recover with at the end.
+                    if(t == static_cast<term>(lxq::token_id::end)){
+                        throw parsing_error(token.first, token.last, token.line_num, token.char_num, token.word_num);
+                    }
+                    t = static_cast<term>(lxq::token_id::error);
+                    while(state_stack.size() > 1){
+                        a = action(state_stack.back(), t);
+                        if(a % 4 != action_shift){
+                            state_stack.pop_back();
+                            value_stack.pop_back();
                             continue;
                         }
                         break;
                     }
-                    table_second = &table.parsing_table.find(state_stack.back())->second;
-                    iter = table_second->find(static_cast<term>(lxq::token_id::error));
-                    if(iter == table_second->end()){
+                    a = action(state_stack.back(), t);
+                    if(a == action_error){
                         throw parsing_error(token.first, token.last, token.line_num, token.char_num, token.word_num);
                     }
                 }
-                parsing_table_item const &i = iter->second;
-                if(i.action == parsing_table_item::enum_action::shift){
-                    state_stack.push_back(i.num);
-                    value_stack.push_back(std::unique_ptr<semantic_data>(nullptr));
-                    value_stack.back().swap(token.value);
-                    ++first;
-                }else if(i.action == parsing_table_item::enum_action::reduce){
-                    auto &p = *table.n2r.find(i.num);
-                    std::size_t norm = p.second.second.norm;
-                    state_stack.resize(state_stack.size() - norm);
+                std::size_t num = a / 4;
+                if(a % 4 == action_shift){
+                    state_stack.push_back(num);
+)text";
+        if(typed){
+            os << "                    value_stack.push_back(shift_value(*this, t, token));\n";
+        }else{
+            os << "                    value_stack.push_back(std::move(token.value));\n";
+        }
+        os << R"text(                    ++first;
+                    if(Push){
+                        return false;
+                    }
+                }else if(a % 4 == action_reduce){
+                    std::size_t n = norm(num);
+                    state_stack.resize(state_stack.size() - n);
                     if(state_stack.empty()){
                         throw parsing_error(token.first, token.last, token.line_num, token.char_num, token.word_num);
                     }
-                    std::vector<std::unique_ptr<semantic_data>> arg;
-                    arg.reserve(norm);
-                    for(std::size_t i = 0; i < norm; ++i){
-                        arg.push_back(std::unique_ptr<semantic_data>(nullptr));
-                        arg.back().swap(std::move(value_stack[value_stack.size() - norm + i]));
-                    }
-                    value_stack.resize(value_stack.size() - norm);
-                    value_stack.push_back(std::move(p.second.second.call(*this, arg)));
-                    state_stack.push_back(table.goto_table.find(state_stack.back())->second.find(p.second.first)->second);
-                }else if(i.action == parsing_table_item::enum_action::accept){
+                    auto v = reduce(num, value_stack.data() + (value_stack.size() - n));
+                    value_stack.resize(value_stack.size() - n);
+                    value_stack.push_back(std::move(v));
+                    state_stack.push_back(goto_state(state_stack.back(), num));
+                }else{
                     if(value_stack.size() != 1){
                         throw parsing_error(token.first, token.last, token.line_num, token.char_num, token.word_num);
                     }
-                    value = std::move(value_stack.front());
                     ++first;
-                    break;
+                    return true;
+                }
+            }
+        }
+)text";
+        os << validate_head;
+        os << R"text(            while(true){
+                std::size_t a = action(state_stack.back(), static_cast<term>((*first).identifier));
+                std::size_t num = a / 4;
+                if(a % 4 == action_shift){
+                    state_stack.push_back(num);
+                    ++first;
+                }else if(a % 4 == action_reduce){
+                    state_stack.resize(state_stack.size() - norm(num));
+                    if(state_stack.empty()){
+                        return first;
+                    }
+                    state_stack.push_back(goto_state(state_stack.back(), num));
+                }else if(a % 4 == action_accept && state_stack.size() == 2){
+                    return last;
+                }else{
+                    return first;
                 }
             }
-            return first;
         }
     };
 }
@@ -1046,8 +2127,75 @@ namespace lxq{
         }
     }
 
-    void scan(const std::string ifile_path, std::string out_path){
+    bool scan_options::parse(std::string const &arg){
+        if(arg == "--lalr-builder=set"){
+            lalr_builder = lalr_builder_type::set;
+            lalr_builder_given = true;
+        }else if(arg == "--lalr-builder=dense"){
+            lalr_builder = lalr_builder_type::dense;
+            lalr_builder_given = true;
+        }else if(arg == "--lalr-lookahead=propagation"){
+            lalr_lookahead = lalr_lookahead_type::propagation;
+        }else if(arg == "--lalr-lookahead=deremer-pennello"){
+            lalr_lookahead = lalr_lookahead_type::deremer_pennello;
+        }else if(arg == "--lexer-backend=goto"){
+            lexer_backend = lexer_backend_type::goto_switch;
+        }else if(arg == "--lexer-backend=table"){
+            lexer_backend = lexer_backend_type::table;
+        }else if(arg == "--lexer-positions=eager"){
+            lexer_positions = automaton::lexer::position_policy::eager;
+        }else if(arg == "--lexer-positions=none"){
+            lexer_positions = automaton::lexer::position_policy::none;
+        }else if(arg == "--lexer-positions=lazy"){
+            lexer_positions = automaton::lexer::position_policy::lazy;
+        }else if(arg == "--parser-backend=table"){
+            parser_backend = parser_backend_type::table;
+        }else if(arg == "--parser-backend=goto"){
+            parser_backend = parser_backend_type::goto_switch;
+        }else if(arg.compare(0, 7, "--jobs=") == 0){
+            std::size_t n = 0;
+            for(char c : arg.substr(7)){
+                if(!std::isdigit(static_cast<unsigned char>(c))){
+                    return false;
+                }
+                n = n * 10 + (c - '0');
+            }
+            if(n == 0){
+                return false;
+            }
+            jobs = n;
+        }else{
+            return false;
+        }
+        return true;
+    }
+
+    // deremer-pennello runs on the dense builder only. it picks that builder
+    // unless another one is given, in any order of the arguments.
+    bool scan_options::resolve(){
+        if(lalr_lookahead == lalr_lookahead_type::deremer_pennello){
+            if(lalr_builder_given && lalr_builder != lalr_builder_type::dense){
+                return false;
+            }
+            lalr_builder = lalr_builder_type::dense;
+        }
+        return true;
+    }
+
+    void scan_options::usage(std::ostream &os){
+        os << "usage: lxq [options] ifile [ofiles_directry]" << std::endl;
+        os << "options:" << std::endl;
+        os << "    --lalr-builder=set|dense" << std::endl;
+        os << "    --lalr-lookahead=propagation|deremer-pennello (deremer-pennello needs the dense builder and implies it)" << std::endl;
+        os << "    --jobs=N (threads for the set builder's LR(0) collection, default 1)" << std::endl;
+        os << "    --lexer-backend=goto|table" << std::endl;
+        os << "    --lexer-positions=eager|none|lazy (line and char numbers of tokens, default eager)" << std::endl;
+        os << "    --parser-backend=table|goto" << std::endl;
+    }
+
+    void scan(const std::string ifile_path, std::string out_path, scan_options const &options){
         try{
+            scanning_data.options = options;
             scanner::grammar grammar;
             init_grammar(grammar);
             scanner sc;
@@ -1059,17 +2207,29 @@ namespace lxq{
             s.pos = 0;
             s.lookahead.insert(eos_functor()());
 
-            sc.make_follow_set(grammar, s.lhs);
             scanner::states states_prime, states;
-            scanner::states::iterator first_state = states.end();
-            sc.lr0_kernel_items(grammar, states_prime, states, first_state, terminal_symbol_set, s);
-            sc.make_goto_map(grammar, terminal_symbol_set, states_prime, states, s);
-            sc.completion_lookahead(grammar, states, first_state, s);
-
-            scanner::items::iterator first_item;
-            states_prime.clear();
-            states = sc.c_closure(grammar, states, first_state, first_item);
-            scanner::make_result make_result = sc.make2(grammar, states, states.end(), s, symbol_data_map);
+            scanner::make_result make_result;
+            if(options.lalr_builder == scan_options::lalr_builder_type::dense){
+                scanner::dense_builder builder(grammar, sc.analysis(grammar), s);
+                builder.make_lr0();
+                if(options.lalr_lookahead == scan_options::lalr_lookahead_type::deremer_pennello){
+                    builder.make_lookahead_deremer_pennello();
+                }else{
+                    builder.make_lookahead();
+                }
+                make_result = builder.make(states, false, symbol_data_map);
+            }else{
+                sc.make_follow_set(grammar, s.lhs);
+                scanner::states::iterator first_state = states.end();
+                sc.lr0_kernel_items(grammar, states_prime, states, first_state, terminal_symbol_set, s, options.jobs);
+                sc.make_goto_map(grammar, terminal_symbol_set, states_prime, states, s, options.jobs);
+                sc.completion_lookahead(grammar, states, first_state, s);
+
+                scanner::items::iterator first_item;
+                states_prime.clear();
+                states = sc.c_closure(grammar, states, first_state, first_item);
+                make_result = sc.make2(grammar, states, states.end(), s, symbol_data_map);
+            }
             if(!make_result.conflict_set.empty()){
                 throw std::runtime_error("bootstrap parser parsing error.");
             }
@@ -1124,7 +2284,11 @@ namespace lxq{
             }
 
             scanning_data.generate_cpp_semantic_data(lxq_hpp);
-            scanning_data.automaton_lexer.generate_cpp(lexer_hpp, scanning_data.regexp_namespace->token.value.to_str());
+            if(options.lexer_backend == scan_options::lexer_backend_type::table){
+                scanning_data.automaton_lexer.generate_cpp_table(lexer_hpp, scanning_data.regexp_namespace->token.value.to_str(), options.lexer_positions);
+            }else{
+                scanning_data.automaton_lexer.generate_cpp(lexer_hpp, scanning_data.regexp_namespace->token.value.to_str(), options.lexer_positions);
+            }
             scanning_data.generate_cpp(grammar_hpp);
         }catch(lalr_generator_type::exception_seq seq){
             for(std::runtime_error &e : seq){
@@ -172,6 +172,40 @@ namespace scanner{
         }
     };
 
+    struct scan_options{
+        enum class lalr_builder_type{
+            set,
+            dense
+        };
+
+        enum class lalr_lookahead_type{
+            propagation,
+            deremer_pennello
+        };
+
+        enum class lexer_backend_type{
+            goto_switch,
+            table
+        };
+
+        enum class parser_backend_type{
+            table,
+            goto_switch
+        };
+
+        lalr_builder_type lalr_builder = lalr_builder_type::set;
+        lalr_lookahead_type lalr_lookahead = lalr_lookahead_type::propagation;
+        std::size_t jobs = 1;
+        lexer_backend_type lexer_backend = lexer_backend_type::goto_switch;
+        automaton::lexer::position_policy lexer_positions = automaton::lexer::position_policy::eager;
+        parser_backend_type parser_backend = parser_backend_type::table;
+        bool lalr_builder_given = false;
+
+        bool parse(std::string const &arg);
+        bool resolve();
+        static void usage(std::ostream &os);
+    };
+
     class scanning_data_type{
     public:
         enum class linkdir{
@@ -204,6 +238,7 @@ namespace scanner{
         struct symbol_data_type{
             std::size_t priority;
             linkdir dir;
+            token_type value_type;
         };
 
         using symbol_data_map_type = std::map<token_type, symbol_data_type>;
@@ -224,11 +259,13 @@ namespace scanner{
         using rhs_seq_set = std::set<rhs_seq>;
         std::vector<token_type> ordered_lhs;
         std::map<token_type, rhs_seq_set> rules;
+        std::map<token_type, token_type> lhs_value_type_map;
         scanning_exception_seq expr_statements_error;
         lalr_generator_type::states states_prime, states;
         automaton::lexer automaton_lexer;
         lalr_generator_type lalr_generator;
         lalr_generator_type::make_result lalr_generator_make_result;
+        scan_options options;
 
         ~scanning_data_type();
 
@@ -237,10 +274,13 @@ namespace scanner{
         void generate_cpp(std::ostream &os);
 
     private:
+        bool has_value_types() const;
+        std::string value_type_str(token_type const &symbol) const;
         void check_reserved_token(token_type const &token);
         ast const *get_arg_opt(ast const *ptr);
         ast const *get_semantic_action(ast const *ptr);
         ast const *get_tag_opt(ast const *ptr);
+        ast const *get_value_type_opt(ast const *ptr);
         void check_recover_rhs_seq(rhs_seq const &rhs_seq_element);
         void get_rhs_seq(ast const *ptr, rhs_seq &seq);
         rhs_seq get_rhs_seq_opt(ast const *ptr);
@@ -324,7 +364,7 @@ namespace scanner{
 
     void init_lexer(lexer &lex);
     void init_grammar(scanner::grammar &grammar);
-    void scan(const std::string ifile_path, std::string out_path);
+    void scan(const std::string ifile_path, std::string out_path, scan_options const &options = scan_options());
 } // namespace scanner
 
 #endif // SCANNER_HPP_